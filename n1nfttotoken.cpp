@@ -1,11 +1,16 @@
 #include <eosio/eosio.hpp>
 #include <eosio/asset.hpp>
+#include <eosio/crypto.hpp>
 #include <eosio/symbol.hpp>
 #include <eosio/string.hpp>
 #include <eosio/system.hpp>
 
+#include "n1staking.hpp"
+
 using namespace eosio;
 
+typedef n1engine::engine<n1engine::nft_kind, n1engine::token_kind> nfttotoken_engine;
+
 class [[eosio::contract("n1nfttotoken")]] n1nfttotoken : public contract {
 public:
   using contract::contract;
@@ -28,46 +33,84 @@ public:
                  asset reward, uint64_t places, uint64_t memo_expected)  {
     require_auth(get_self());
 
+    create_campaign(campaign, start, finish, timetoreward, nftaccount, tokenaccount, reward, places, memo_expected);
+  }
+
+
+// Parameters of one campaign in setcampaigns, same meaning as in setcampaign
+  struct campaign_config {
+    name campaign;
+    uint64_t start;
+    uint64_t finish;
+    uint64_t timetoreward;
+    name nftaccount;
+    name tokenaccount;
+    asset reward;
+    uint64_t places;
+    uint64_t memo_expected;
+  };
+
+// Set up several stake campaigns in one transaction
+    //campaigns - One entry per campaign, validated like setcampaign
+
+  [[eosio::action]]
+  void setcampaigns(std::vector<campaign_config> campaigns) {
+    require_auth(get_self());
+
     
-    campaigndata_table campaigndata(get_self(), get_self().value);
-    auto existing = campaigndata.find(campaign.value);
-    check(existing == campaigndata.end(), "The campaign already exists in the table campaigndata");
+    check(!campaigns.empty(), "No campaigns to set up");
+
+    for (const auto& config : campaigns) {
+      create_campaign(config.campaign, config.start, config.finish, config.timetoreward, config.nftaccount,
+                      config.tokenaccount, config.reward, config.places, config.memo_expected);
+    }
+  }
+
+
+// Update the mutable parameters of a campaign without recreating it
+    //campaign - Name of the campaign in the table
+    //finish - New UNIX time to end the campaign
+    //places - New maximum number of participants, not lower than the current ones
+    //reward - New number of reward tokens, same symbol as before
+
+  [[eosio::action]]
+  void updcampaign(name campaign, uint64_t finish, uint64_t places, asset reward) {
+    require_auth(get_self());
 
     
-    check(memo_expected > 0, "memo_expected must be a valid number");
+    campaigndata_table campaigndata(get_self(), get_self().value);
+    auto campaign_itr = campaigndata.find(campaign.value);
+    check(campaign_itr != campaigndata.end(), "The campaign does not exist in the table campaigndata");
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto hot_itr = campaignhot.find(campaign.value);
+    check(hot_itr != campaignhot.end(), "The campaign does not exist in the table campaigndata");
 
     
     check(places > 0, "Value of 'places' cannot be equal to 0");
-    
-    
-    auto existing_memo = campaigndata.get_index<"bymemo"_n>();
-    auto itr = existing_memo.find(memo_expected);
-    check(itr == existing_memo.end(), "Already an entry with the same memo_expected");
+    check(places >= hot_itr->joined, "Places cannot be lower than the current participants");
 
     
-    time_point_sec current_time = current_time_point();
-    uint64_t current_time_sec = current_time.sec_since_epoch();
+    check(finish > n1engine::now_sec(), "Date specified in 'finish' has already passed and is invalid.");
+    check(campaign_itr->start < finish, "Start time must be before the end time.");
+    check(campaign_itr->timetoreward < (finish - campaign_itr->start), "Duration is greater to active time");
 
     
-    check(start >= current_time.sec_since_epoch(), "Date specified in 'start' has already passed and is invalid.");
-    
-    
-    check(start < finish, "Start time must be before the end time.");
-    
-    
-    check(timetoreward < (finish - start), "Duration is greater to active time");
+    check(reward.is_valid() && reward.amount > 0, "'reward' must be a positive amount");
+    check(reward.symbol == campaign_itr->reward.symbol, "The symbol of 'reward' cannot change");
 
-    
-    campaigndata.emplace(get_self(), [&](auto& row) {
-      row.campaign = campaign;
-      row.start = start;
+    campaigndata.modify(campaign_itr, get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.finish = finish;
+      row.places = places;
+      row.reward = reward;
+    });
+
+    campaignhot.modify(hot_itr, get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
       row.finish = finish;
-      row.timetoreward = timetoreward;
-      row.nftaccount = nftaccount;
-      row.tokenaccount = tokenaccount;
       row.places = places;
       row.reward = reward;
-      row.memo_expected = memo_expected;
     });
   }
 
@@ -97,6 +140,89 @@ void addnftdata(name campaign, name author, name category, string idata) {
         row.category = category;
         row.idata = idata;
     });
+
+    
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto hot_itr = campaignhot.find(campaign.value);
+    check(hot_itr != campaignhot.end(), "There is no campaign with this name");
+
+    campaignhot.modify(hot_itr, get_self(), [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
+        row.author = author;
+        row.category = category;
+        row.idata_hash = sha256(idata.data(), idata.size());
+        row.has_nftdata = true;
+    });
+}
+
+
+  // Makes participants pay the RAM of their own staker row. Only before the campaign starts.
+    //campaign - Campaign to configure
+    //userram - true if each participant opens and pays for their position
+
+[[eosio::action]]
+void setuserram(name campaign, bool userram) {
+    require_auth(get_self());
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto campaign_itr = campaignhot.find(campaign.value);
+    check(campaign_itr != campaignhot.end(), "There is no campaign with this name");
+
+    time_point_sec current_time = current_time_point();
+    check(current_time.sec_since_epoch() < campaign_itr->start, "The campaign has already started");
+
+    campaignhot.modify(campaign_itr, get_self(), [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
+        row.userram = userram;
+    });
+}
+
+
+  // Creates the staker row of 'user', paid by 'user', for a 'userram' campaign.
+  // Sent in the same transaction before the NFT transfer, which fills the row.
+    //user - Future participant, pays the RAM of the row
+    //campaign - Campaign to join
+
+[[eosio::action]]
+void open(name user, name campaign) {
+    require_auth(user);
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto campaign_itr = campaignhot.find(campaign.value);
+    check(campaign_itr != campaignhot.end(), "There is no campaign with this name");
+    check(campaign_itr->userram, "The contract pays the RAM of this campaign");
+
+    stakers_table stakers(get_self(), get_self().value);
+    check(stakers.find(user.value) == stakers.end(), "You are already participating or have participated.");
+    n1engine::check_not_closed(get_self(), "accounts"_n, user.value, "You are already participating or have participated.");
+
+    stakers.emplace(user, [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
+        row.participant = user;
+        row.campaign = campaign;
+        row.join_time = 0;
+        row.claimable_reward = 0;
+        row.claimed = false;
+        row.retired = false;
+        row.id_nft = 0;
+    });
+}
+
+
+  // Deletes a row created by 'open' that was never filled, giving its RAM back.
+    //user - Owner of the row
+
+[[eosio::action]]
+void close(name user) {
+    require_auth(user);
+
+    stakers_table stakers(get_self(), get_self().value);
+    auto staker_itr = stakers.find(user.value);
+    check(staker_itr != stakers.end(), "You are not registered as a participant in any campaign");
+    check(staker_itr->join_time == 0, "The position is already in use");
+
+    n1engine::record_erase(get_self(), "stakers"_n, user.value);
+    stakers.erase(staker_itr);
 }
 
 
@@ -111,54 +237,75 @@ void claimreward(name user) {
     stakers_table stakers(get_self(), get_self().value);
     auto staker_itr = stakers.find(user.value);
     check(staker_itr != stakers.end(), "You are not registered as a participant in any campaign");
+    check(staker_itr->join_time != 0, "Your position has no NFT staked");
 
-    check(staker_itr->claimed == false && staker_itr->retired == false, "Already claimed or withdrawn from this campaign");
-
-    
-    time_point_sec current_time = current_time_point();
-    uint64_t current_time_sec = current_time.sec_since_epoch();
-    uint64_t user_claimable_reward = staker_itr->claimable_reward;
-
-    check(current_time_sec >= user_claimable_reward, "You have not completed stake time yet!");
+    n1engine::check_claimable(staker_itr->claimed, staker_itr->retired, staker_itr->claimable_reward);
 
     
    
     uint64_t user_id_nft = staker_itr->id_nft;
 
-    std::vector<uint64_t> user_id_nft_vector;
-    user_id_nft_vector.push_back(user_id_nft);
-
 
     
     name user_campaign = staker_itr->campaign;
     
-    campaigndata_table campaigndata(get_self(), get_self().value);
-    auto campaign_itr = campaigndata.find(user_campaign.value);
-    check(campaign_itr != campaigndata.end(), "Corresponding campaign was not found in the campaigndata table.");
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto campaign_itr = campaignhot.find(user_campaign.value);
+    check(campaign_itr != campaignhot.end(), "Corresponding campaign was not found in the campaigndata table.");
 
     name nft_account = campaign_itr->nftaccount;
     name token_account = campaign_itr->tokenaccount;
     asset rewardclaim = campaign_itr->reward;
 
-    action(
-        permission_level{get_self(), "active"_n},
-        nft_account,
-        "transfer"_n,
-        std::make_tuple(get_self(), user, user_id_nft_vector, std::string("NFT returned"))
-    ).send();
+    
+    bundles_table bundles(get_self(), get_self().value);
+    auto bundle_itr = bundles.find(user_campaign.value);
+
+    if (bundle_itr == bundles.end()) {
+      nfttotoken_engine::refund(get_self(), nft_account, user, asset(), user_id_nft, "NFT returned");
+
+      nfttotoken_engine::payout(get_self(), token_account, user, rewardclaim, 0, "Tokens claimed");
+    } else {
+      // The staked NFT and the bundle NFT travel together when they share a contract,
+      // and tokens are merged so there is one transfer per contract and symbol.
+      std::vector<uint64_t> nfts_returned;
+      nfts_returned.push_back(user_id_nft);
+
+      if (bundle_itr->nftaccount != name()) {
+        uint64_t bundle_nft = take_bundle_nft(user_campaign);
+        if (bundle_itr->nftaccount == nft_account) {
+          nfts_returned.push_back(bundle_nft);
+        } else {
+          n1engine::send_nft(get_self(), bundle_itr->nftaccount, user, bundle_nft, "NFT claimed");
+        }
+      }
+
+      n1engine::send_nfts(get_self(), nft_account, user, nfts_returned, "NFT returned");
 
-    action(
-        permission_level{get_self(), "active"_n},
-        token_account,
-        "transfer"_n,
-        std::make_tuple(get_self(), user, rewardclaim, std::string("Tokens claimed"))
-    ).send();
+      std::vector<extended_asset> tokens;
+      n1engine::merge_asset(tokens, extended_asset(rewardclaim, token_account));
+      for (const auto& entry : bundle_itr->tokens) {
+        n1engine::merge_asset(tokens, entry);
+      }
+      n1engine::send_bundle(get_self(), user, tokens, "Tokens claimed");
+    }
 
      
+    // Rows paid by the user are deleted so the RAM goes back to them.
+    if (campaign_itr->userram) {
+        n1engine::mark_closed(get_self(), user, "accounts"_n, user.value);
+        n1engine::mark_closed(get_self(), user, "nfts"_n, user_id_nft);
+        n1engine::record_erase(get_self(), "stakers"_n, user.value);
+        stakers.erase(staker_itr);
+    } else {
     stakers.modify(staker_itr, get_self(), [&](auto& row) {
+    row.rev = n1engine::next_revision(get_self());
     row.claimed = true;
 
 });  
+    }
+
+    n1engine::send_receipt(get_self(), user_campaign, user, rewardclaim, user_id_nft, n1engine::receipt_status::claimed);
 }
 
 
@@ -173,43 +320,151 @@ void retirestake(name user) {
     stakers_table stakers(get_self(), get_self().value);
     auto staker_itr = stakers.find(user.value);
     check(staker_itr != stakers.end(), "You are not registered as a participant in any campaign");
+    check(staker_itr->join_time != 0, "Your position has no NFT staked");
 
-    check(staker_itr->claimed == false && staker_itr->retired == false, "Already claimed or withdrawn from this campaign");
-
-    
-    time_point_sec current_time = current_time_point();
-    uint64_t current_time_sec = current_time.sec_since_epoch();
-    uint64_t user_claimable_reward = staker_itr->claimable_reward;
-
-    check(current_time_sec < user_claimable_reward, "You cannot withdraw, claim your reward.");
+    n1engine::check_retirable(staker_itr->claimed, staker_itr->retired, staker_itr->claimable_reward);
 
     
     uint64_t user_id_nft = staker_itr->id_nft;
 
-    std::vector<uint64_t> user_id_nft_vector;
-    user_id_nft_vector.push_back(user_id_nft);
-
     
     name user_campaign = staker_itr->campaign;
 
-    campaigndata_table campaigndata(get_self(), get_self().value);
-    auto campaign_itr = campaigndata.find(user_campaign.value);
-    check(campaign_itr != campaigndata.end(), "Corresponding campaign was not found in the campaigndata table.");
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto campaign_itr = campaignhot.find(user_campaign.value);
+    check(campaign_itr != campaignhot.end(), "Corresponding campaign was not found in the campaigndata table.");
 
     name nft_account = campaign_itr->nftaccount;
 
-    action(
-        permission_level{get_self(), "active"_n},
-        nft_account,
-        "transfer"_n,
-        std::make_tuple(get_self(), user, user_id_nft_vector, std::string("NFT returned"))
-    ).send();
+    nfttotoken_engine::refund(get_self(), nft_account, user, asset(), user_id_nft, "NFT returned");
+
 
+    
+    bundles_table bundles(get_self(), get_self().value);
+    auto bundle_itr = bundles.find(user_campaign.value);
+    if (bundle_itr != bundles.end() && bundle_itr->nftaccount != name()) {
+        bundles.modify(bundle_itr, get_self(), [&](auto& row) {
+            row.nfts_available++;
+        });
+    }
 
     
+    if (campaign_itr->userram) {
+        n1engine::mark_closed(get_self(), user, "accounts"_n, user.value);
+        n1engine::mark_closed(get_self(), user, "nfts"_n, user_id_nft);
+        n1engine::record_erase(get_self(), "stakers"_n, user.value);
+        stakers.erase(staker_itr);
+    } else {
     stakers.modify(staker_itr, get_self(), [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
         row.retired = true;
     });
+    }
+
+    n1engine::send_receipt(get_self(), user_campaign, user, asset(), user_id_nft, n1engine::receipt_status::retired);
+}
+
+
+
+// Sets the extra rewards paid together with 'reward' when claiming
+    //campaign - Campaign to which to add the bundle
+    //tokens - Extra tokens, each with the contract that manages it
+    //nftaccount - Contract of the NFT included in the bundle, empty for none
+
+[[eosio::action]]
+void setbundle(name campaign, std::vector<extended_asset> tokens, name nftaccount) {
+    require_auth(get_self());
+
+    
+    campaigndata_table campaigndata(get_self(), get_self().value);
+    auto campaign_itr = campaigndata.find(campaign.value);
+    check(campaign_itr != campaigndata.end(), "There is no campaign with this name");
+
+    
+    std::vector<extended_asset> merged;
+    for (const auto& entry : tokens) {
+      check(entry.quantity.is_valid() && entry.quantity.amount > 0, "Bundle tokens must be positive amounts");
+      n1engine::merge_asset(merged, entry);
+    }
+
+    // Joins reserve a bundle NFT, so the NFT side of the bundle is fixed once the campaign starts.
+    bool started = n1engine::now_sec() >= campaign_itr->start;
+
+    
+    bundles_table bundles(get_self(), get_self().value);
+    auto bundle_itr = bundles.find(campaign.value);
+
+    if (bundle_itr == bundles.end()) {
+      check(!started || nftaccount == name(), "The bundle NFT can only be set before the campaign starts");
+
+      bundles.emplace(get_self(), [&](auto& row) {
+        row.campaign = campaign;
+        row.tokens = merged;
+        row.nftaccount = nftaccount;
+        row.nfts_available = 0;
+      });
+    } else {
+      check(bundle_itr->nftaccount == nftaccount || !started, "The bundle NFT can only be set before the campaign starts");
+      check(bundle_itr->nftaccount == nftaccount || bundle_itr->nfts_available == 0, "Remove the bundle NFTs before changing 'nftaccount'");
+
+      bundles.modify(bundle_itr, get_self(), [&](auto& row) {
+        row.tokens = merged;
+        row.nftaccount = nftaccount;
+      });
+    }
+}
+
+
+
+// Adds NFTs already owned by the contract to the bundle of a campaign.
+// NFTs can also be sent to the contract with the memo "bundle:<campaign>".
+    //campaign - Campaign of the bundle
+    //assetids - IDs of the NFTs, one is paid to each participant
+
+[[eosio::action]]
+void addbundlenft(name campaign, std::vector<uint64_t> assetids) {
+    require_auth(get_self());
+
+    
+    bundles_table bundles(get_self(), get_self().value);
+    auto bundle_itr = bundles.find(campaign.value);
+    check(bundle_itr != bundles.end(), "There is no bundle for this campaign");
+
+    
+    n1engine::sassets_table sassets(bundle_itr->nftaccount, get_self().value);
+    for (uint64_t id : assetids) {
+      check(sassets.find(id) != sassets.end(), "The contract does not own this NFT");
+    }
+
+    add_bundle_nfts(bundles, bundle_itr, get_self(), assetids);
+}
+
+
+
+ // Allows you to delete the bundle of a campaign and its pending NFTs.
+    //campaign - Campaign you want to delete from table.
+    //memo - "Confirm" for security
+
+[[eosio::action]]
+void delbundle(name campaign, string memo) {
+    require_auth(get_self());
+
+    
+    check(memo == "confirm", "Fail");
+
+    
+    bundles_table bundles(get_self(), get_self().value);
+    auto bundle_itr = bundles.find(campaign.value);
+    check(bundle_itr != bundles.end(), "The campaign does not exist in the table bundles");
+
+    bundlenfts_table bundlenfts(get_self(), get_self().value);
+    auto by_campaign = bundlenfts.get_index<"bycampaign"_n>();
+    auto nft_itr = by_campaign.lower_bound(campaign.value);
+    while (nft_itr != by_campaign.end() && nft_itr->campaign == campaign) {
+      nft_itr = by_campaign.erase(nft_itr);
+    }
+
+    bundles.erase(bundle_itr);
 }
 
 
@@ -231,7 +486,19 @@ void delcampaign(name campaign, string memo) {
     check(campaign_itr != campaigndata.end(), "The campaign does not exist in the table campaigndata");
 
     
+    n1engine::erase_memo(get_self(), campaign_itr->memo_expected);
+    n1engine::set_allowlist(get_self(), campaign, checksum256());
+    n1engine::record_erase(get_self(), "campaigndata"_n, campaign.value);
     campaigndata.erase(campaign_itr);
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto hot_itr = campaignhot.find(campaign.value);
+    if (hot_itr != campaignhot.end()) {
+      n1engine::record_erase(get_self(), "campaignhot"_n, campaign.value);
+      campaignhot.erase(hot_itr);
+    }
+
+    n1engine::send_receipt(get_self(), campaign, get_self(), asset(), 0, n1engine::receipt_status::deleted);
 }
 
 
@@ -254,6 +521,15 @@ void delnftdata(name campaign, string memo) {
 
    
     nftdata.erase(nftdata_itr);
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto hot_itr = campaignhot.find(campaign.value);
+    if (hot_itr != campaignhot.end()) {
+      campaignhot.modify(hot_itr, get_self(), [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
+        row.has_nftdata = false;
+      });
+    }
 }
 
 
@@ -275,50 +551,414 @@ void delstakers(name campaign, string memo) {
     auto staker_itr = stakers.begin();
     while (staker_itr != stakers.end()) {
         if (staker_itr->campaign == campaign) {
+            n1engine::record_erase(get_self(), "stakers"_n, staker_itr->participant.value);
             staker_itr = stakers.erase(staker_itr);
         } else {
             ++staker_itr;
         }
     }
+
+    
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto hot_itr = campaignhot.find(campaign.value);
+    if (hot_itr != campaignhot.end()) {
+      campaignhot.modify(hot_itr, get_self(), [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
+        row.joined = 0;
+      });
+    }
+}
+
+
+// Restricts a campaign to the accounts of a Merkle tree
+    //campaign - Campaign to restrict
+    //root - Merkle root of the leaves sha256(pack(account)), empty to open the campaign to everyone
+
+[[eosio::action]]
+void setallowlist(name campaign, checksum256 root) {
+    require_auth(get_self());
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    check(campaignhot.find(campaign.value) != campaignhot.end(), "There is no campaign with this name");
+
+    n1engine::set_allowlist(get_self(), campaign, root);
 }
 
 
+// Proves that 'user' is in the allowlist of a campaign. Sent in the same transaction before the NFT transfer.
+    //user - Account joining the campaign
+    //campaign - Campaign with an allowlist
+    //proof - Merkle proof of the leaf sha256(pack(user))
+
+[[eosio::action]]
+void prove(name user, name campaign, std::vector<checksum256> proof) {
+    require_auth(user);
+    n1engine::add_pass(get_self(), campaign, user, proof);
+}
+
+
+// Set up a snapshot distribution claimed with a Merkle proof instead of staking an NFT
+    //campaign - Name of the distribution
+    //root - Merkle root of the leaves sha256(pack(index, account, amount))
+    //tokenaccount - Contract that handles Tokens used in the distribution
+    //leaves - Number of leaves in the tree
+
+[[eosio::action]]
+void setmerkle(name campaign, checksum256 root, name tokenaccount, uint64_t leaves) {
+    require_auth(get_self());
+
+    
+    check(leaves > 0, "Value of 'leaves' cannot be equal to 0");
+
+    
+    merkledrops_table merkledrops(get_self(), get_self().value);
+    auto drop_itr = merkledrops.find(campaign.value);
+    check(drop_itr == merkledrops.end(), "The campaign already exists in the table merkledrops");
+
+    merkledrops.emplace(get_self(), [&](auto& row) {
+      row.campaign = campaign;
+      row.root = root;
+      row.tokenaccount = tokenaccount;
+      row.leaves = leaves;
+    });
+
+    n1engine::send_receipt(get_self(), campaign, get_self(), asset(), 0, n1engine::receipt_status::created);
+}
+
+
+
+// Claims the tokens of a snapshot leaf
+    //campaign - Name of the distribution
+    //user - Account of the leaf
+    //index - Position of the leaf in the tree
+    //amount - Tokens of the leaf
+    //proof - Sibling hashes from the leaf up to the root
+
+[[eosio::action]]
+void merkleclaim(name campaign, name user, uint64_t index, asset amount, std::vector<checksum256> proof) {
+    require_auth(user);
+
+    
+    merkledrops_table merkledrops(get_self(), get_self().value);
+    auto drop_itr = merkledrops.find(campaign.value);
+    check(drop_itr != merkledrops.end(), "The campaign does not exist in the table merkledrops");
+    check(index < drop_itr->leaves, "Leaf index out of range");
+
+    
+    std::vector<char> leaf_data = pack(std::make_tuple(index, user, amount));
+    checksum256 leaf = sha256(leaf_data.data(), leaf_data.size());
+    check(n1engine::merkle_verify(leaf, proof, drop_itr->root), "Invalid Merkle proof");
+
+    
+    // One 64-bit word per 64 leaves, only created once a leaf of that word is claimed.
+    claimedbits_table claimedbits(get_self(), campaign.value);
+    uint64_t word = index / 64;
+    uint64_t bit = uint64_t(1) << (index % 64);
+
+    auto bits_itr = claimedbits.find(word);
+    if (bits_itr == claimedbits.end()) {
+      claimedbits.emplace(get_self(), [&](auto& row) {
+        row.word = word;
+        row.bits = bit;
+      });
+    } else {
+      check((bits_itr->bits & bit) == 0, "Already claimed");
+      claimedbits.modify(bits_itr, get_self(), [&](auto& row) {
+        row.bits |= bit;
+      });
+    }
+
+    n1engine::send_tokens(get_self(), drop_itr->tokenaccount, user, amount, "Tokens claimed");
+
+    n1engine::send_receipt(get_self(), campaign, user, amount, index, n1engine::receipt_status::claimed);
+}
+
+
+
+ // Allows you to delete a snapshot distribution and its claimed bitmap.
+    //campaign - Distribution you want to delete from table.
+    //memo - "Confirm" for security
+
+[[eosio::action]]
+void delmerkle(name campaign, string memo) {
+    require_auth(get_self());
+
+    
+    check(memo == "confirm", "Fail");
+
+    
+    merkledrops_table merkledrops(get_self(), get_self().value);
+    auto drop_itr = merkledrops.find(campaign.value);
+    check(drop_itr != merkledrops.end(), "The campaign does not exist in the table merkledrops");
+
+    claimedbits_table claimedbits(get_self(), campaign.value);
+    auto bits_itr = claimedbits.begin();
+    while (bits_itr != claimedbits.end()) {
+      bits_itr = claimedbits.erase(bits_itr);
+    }
+
+    merkledrops.erase(drop_itr);
+
+    n1engine::send_receipt(get_self(), campaign, get_self(), asset(), 0, n1engine::receipt_status::deleted);
+}
+
+
+// No-op notification sent by the contract on every campaign transition. See n1engine::send_receipt.
+
+[[eosio::action]]
+void receipt(name campaign, name account, asset quantity, uint64_t id, uint8_t status, uint32_t timestamp) {
+    require_auth(get_self());
+}
+
+
+// Rewrites the campaigndata and stakers rows stored by the previous version of the
+// contract with the current layout and indexes, registers the memo of each old campaign
+// and builds its campaignhot row with its participant count. Call it until the migration is complete.
+    //max_rows - Maximum number of rows visited in this call
+
+[[eosio::action]]
+void migrate(uint64_t max_rows) {
+    require_auth(get_self());
+
+    n1engine::migration_singleton migration(get_self(), get_self().value);
+    n1engine::migration_state state = migration.get_or_default();
+    check(state.table < 2, "The migration is complete");
+
+    uint64_t budget = max_rows;
+    campaignhot_table campaignhot(get_self(), get_self().value);
+
+    while (state.table < 2 && budget > 0) {
+      bool done = false;
+
+      if (state.table == 0) {
+        legacy_campaigndata_table legacy(get_self(), get_self().value);
+        campaigndata_table campaigndata(get_self(), get_self().value);
+        done = n1engine::migrate_rows(legacy, state.next_key, budget, [&](const auto& old) {
+          campaigndata.emplace(get_self(), [&](auto& row) {
+            row.rev = n1engine::next_revision(get_self());
+            row.campaign = old.campaign;
+            row.start = old.start;
+            row.finish = old.finish;
+            row.timetoreward = old.timetoreward;
+            row.nftaccount = old.nftaccount;
+            row.tokenaccount = old.tokenaccount;
+            row.reward = old.reward;
+            row.places = old.places;
+            row.memo_expected = old.memo_expected;
+          });
+
+          n1engine::add_memo(get_self(), old.memo_expected, old.campaign);
+
+          nftdata_table nftdata(get_self(), get_self().value);
+          auto nftdata_itr = nftdata.find(old.campaign.value);
+
+          campaignhot.emplace(get_self(), [&](auto& row) {
+            row.rev = n1engine::next_revision(get_self());
+            row.campaign = old.campaign;
+            row.start = old.start;
+            row.finish = old.finish;
+            row.timetoreward = old.timetoreward;
+            row.places = old.places;
+            row.joined = 0;
+            row.nftaccount = old.nftaccount;
+            row.tokenaccount = old.tokenaccount;
+            row.reward = old.reward;
+            row.has_nftdata = nftdata_itr != nftdata.end();
+            if (row.has_nftdata) {
+              row.author = nftdata_itr->author;
+              row.category = nftdata_itr->category;
+              row.idata_hash = sha256(nftdata_itr->idata.data(), nftdata_itr->idata.size());
+            }
+            row.userram = false;
+          });
+        });
+      } else {
+        legacy_stakers_table legacy(get_self(), get_self().value);
+        stakers_table stakers(get_self(), get_self().value);
+        done = n1engine::migrate_rows(legacy, state.next_key, budget, [&](const auto& old) {
+          stakers.emplace(get_self(), [&](auto& row) {
+            row.rev = n1engine::next_revision(get_self());
+            row.participant = old.participant;
+            row.campaign = old.campaign;
+            row.join_time = old.join_time;
+            row.claimable_reward = old.claimable_reward;
+            row.claimed = old.claimed;
+            row.retired = old.retired;
+            row.id_nft = old.id_nft;
+          });
+
+          // Every staker row of a campaign used one of its places.
+          auto hot_itr = campaignhot.find(old.campaign.value);
+          if (hot_itr != campaignhot.end()) {
+            campaignhot.modify(hot_itr, get_self(), [&](auto& row) {
+              row.rev = n1engine::next_revision(get_self());
+              row.joined++;
+            });
+          }
+        });
+      }
+
+      if (done) {
+        state.table++;
+        state.next_key = 0;
+      }
+    }
+
+    migration.set(state, get_self());
+}
+
+
+// Lists campaigndata, campaignhot and stakers rows modified or erased after a revision, oldest first.
+    //since_rev - Last revision already seen by the caller, 0 for everything
+    //limit - Maximum number of rows returned
+
+[[eosio::action, eosio::read_only]]
+std::vector<n1engine::row_change> changes(uint64_t since_rev, uint32_t limit) {
+    std::vector<n1engine::row_change> result;
+
+    campaigndata_table campaigndata(get_self(), get_self().value);
+    n1engine::collect_changes(campaigndata.get_index<"byrev"_n>(), "campaigndata"_n, since_rev, limit, result);
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    n1engine::collect_changes(campaignhot.get_index<"byrev"_n>(), "campaignhot"_n, since_rev, limit, result);
+
+    stakers_table stakers(get_self(), get_self().value);
+    n1engine::collect_changes(stakers.get_index<"byrev"_n>(), "stakers"_n, since_rev, limit, result);
+
+    n1engine::collect_erased(get_self(), since_rev, limit, result);
+
+    n1engine::sort_changes(result, limit);
+    return result;
+}
+
+
+// Exports rows of 'campaigndata', 'campaignhot', 'nftdata', 'bundles', 'bundlenfts', 'allowlists'
+// or 'stakers' in packed pages for 'importrows'.
+    //table - Table to read
+    //lower_key - First primary key of the page, 'next_key' of the previous page
+    //limit - Maximum number of rows in the page
+
+[[eosio::action, eosio::read_only]]
+n1engine::snapshot_page exportrows(name table, uint64_t lower_key, uint32_t limit) {
+    if (table == "campaigndata"_n) {
+      campaigndata_table campaigndata(get_self(), get_self().value);
+      return n1engine::export_rows(campaigndata, lower_key, limit);
+    }
+    if (table == "campaignhot"_n) {
+      campaignhot_table campaignhot(get_self(), get_self().value);
+      return n1engine::export_rows(campaignhot, lower_key, limit);
+    }
+    if (table == "nftdata"_n) {
+      nftdata_table nftdata(get_self(), get_self().value);
+      return n1engine::export_rows(nftdata, lower_key, limit);
+    }
+    if (table == "bundles"_n) {
+      bundles_table bundles(get_self(), get_self().value);
+      return n1engine::export_rows(bundles, lower_key, limit);
+    }
+    if (table == "bundlenfts"_n) {
+      bundlenfts_table bundlenfts(get_self(), get_self().value);
+      return n1engine::export_rows(bundlenfts, lower_key, limit);
+    }
+    if (table == "allowlists"_n) {
+      n1engine::allowlists_table allowlists(get_self(), get_self().value);
+      return n1engine::export_rows(allowlists, lower_key, limit);
+    }
+
+    check(table == "stakers"_n, "This table cannot be exported");
+    stakers_table stakers(get_self(), get_self().value);
+    return n1engine::export_rows(stakers, lower_key, limit);
+}
+
+
+#ifdef N1STAKING_IMPORT
+// Loads a page produced by 'exportrows' to set up test and benchmark environments
+// without replaying transfers. Only compiled with -DN1STAKING_IMPORT, never in production.
+// Imported rows get new revisions, so 'changes' on the local node starts from them.
+    //table - Table the rows belong to
+    //rows - The 'rows' of a snapshot_page
+
+[[eosio::action]]
+void importrows(name table, std::vector<char> rows) {
+    require_auth(get_self());
+
+    if (table == "campaigndata"_n) {
+      campaigndata_table campaigndata(get_self(), get_self().value);
+      n1engine::import_rows(campaigndata, get_self(), rows, [&](auto& row) {
+        n1engine::add_memo(get_self(), row.memo_expected, row.campaign);
+        row.rev = n1engine::next_revision(get_self());
+      });
+    } else if (table == "campaignhot"_n) {
+      campaignhot_table campaignhot(get_self(), get_self().value);
+      n1engine::import_rows(campaignhot, get_self(), rows, [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
+      });
+    } else if (table == "nftdata"_n) {
+      nftdata_table nftdata(get_self(), get_self().value);
+      n1engine::import_rows(nftdata, get_self(), rows, [](auto&) {});
+    } else if (table == "bundles"_n) {
+      bundles_table bundles(get_self(), get_self().value);
+      n1engine::import_rows(bundles, get_self(), rows, [](auto&) {});
+    } else if (table == "bundlenfts"_n) {
+      bundlenfts_table bundlenfts(get_self(), get_self().value);
+      n1engine::import_rows(bundlenfts, get_self(), rows, [](auto&) {});
+    } else if (table == "allowlists"_n) {
+      for (const auto& allowlist : unpack<std::vector<n1engine::allowlist_row>>(rows)) {
+        n1engine::set_allowlist(get_self(), allowlist.campaign, allowlist.root);
+      }
+    } else {
+      check(table == "stakers"_n, "This table cannot be imported");
+      stakers_table stakers(get_self(), get_self().value);
+      n1engine::import_rows(stakers, get_self(), rows, [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
+      });
+    }
+}
+#endif
+
+
 //Logic to receive the nft and to be registered in the campaign as a staker.
 
 [[eosio::on_notify("simpleassets::transfer")]]
 void nft_transfer(name from, name to, std::vector<uint64_t>& assetids, std::string memo) {
     if (to == get_self()) {
         
+        // Bundle deposits, co-signed by the contract so nobody else can fill the pool.
+        if (memo.rfind("bundle:", 0) == 0) {
+            check(has_auth(get_self()), "Bundle NFTs must be authorized by the contract");
+
+            bundles_table bundles(get_self(), get_self().value);
+            auto bundle_itr = bundles.find(name(memo.substr(7)).value);
+            check(bundle_itr != bundles.end(), "There is no bundle for this campaign");
+            check(get_first_receiver() == bundle_itr->nftaccount, "Invalid nft contract");
+
+            add_bundle_nfts(bundles, bundle_itr, from, assetids);
+            return;
+        }
+
+        
         check(!memo.empty(), "Memo must not be empty");
 
+        uint64_t memo_value;
+        check(n1engine::parse_number(memo, memo_value), "Memo must be a campaign number");
+
        
-        campaigndata_table campaigndata(get_self(), get_self().value);
-        auto by_memo_index = campaigndata.get_index<"bymemo"_n>();
-        auto campaign_itr = by_memo_index.find(stoull(memo));
+        campaignhot_table campaignhot(get_self(), get_self().value);
+        auto campaign_itr = campaignhot.find(n1engine::find_memo(get_self(), memo_value).value);
 
        
-        if (campaign_itr != by_memo_index.end()) {
+        if (campaign_itr != campaignhot.end()) {
            
 
             
             name matching_campaign_name = campaign_itr->campaign;
 
             
-            nftdata_table nftdata(get_self(), get_self().value);
-            auto nftdata_itr = nftdata.find(matching_campaign_name.value);
+            eosio::check(campaign_itr->has_nftdata, "The campaign has no nft data");
 
             
-            if (nftdata_itr != nftdata.end()) {
-             }
-
-            
-            time_point_sec current_time = current_time_point();
-            uint64_t current_time_sec = current_time.sec_since_epoch();
-            uint64_t campaign_start = campaign_itr->start;
-            uint64_t campaign_finish = campaign_itr->finish;
-
-            eosio::check(current_time_sec > campaign_start, "Campaign has not yet started.");
-            eosio::check(current_time_sec < campaign_finish, "This campaign has already ended.");
+            n1engine::check_active(campaign_itr->start, campaign_itr->finish);
+            uint64_t current_time_sec = n1engine::now_sec();
 
             name nft_account = campaign_itr->nftaccount;
             name sender_contract = get_first_receiver();
@@ -329,62 +969,71 @@ void nft_transfer(name from, name to, std::vector<uint64_t>& assetids, std::stri
             uint64_t transaction_id = asset_ids[0];
 
             
-            sassets_table sassets("simpleassets"_n, get_self().value);
+            n1engine::sassets_table sassets("simpleassets"_n, get_self().value);
             auto asset_itr = sassets.find(transaction_id);
 
             
             if (asset_itr != sassets.end()) {
                 
-                eosio::check(nftdata_itr->author == asset_itr->author, "The 'author' data do not match");
-                eosio::check(nftdata_itr->category == asset_itr->category, "The 'category' data do not match");
-                eosio::check(nftdata_itr->idata == asset_itr->idata, "The 'idata' data do not match");
+                eosio::check(campaign_itr->author == asset_itr->author, "The 'author' data do not match");
+                eosio::check(campaign_itr->category == asset_itr->category, "The 'category' data do not match");
+                eosio::check(campaign_itr->idata_hash == sha256(asset_itr->idata.data(), asset_itr->idata.size()), "The 'idata' data do not match");
 
                 
                stakers_table stakers(get_self(), get_self().value);
                auto staker_itr = stakers.find(from.value);
 
-               
-               if (staker_itr != stakers.end()) {
+               // A 'userram' position is the empty row opened by the user for this campaign.
+               bool opened = staker_itr != stakers.end() && staker_itr->join_time == 0 &&
+                             staker_itr->campaign == matching_campaign_name;
+
+               if (staker_itr != stakers.end() && !opened) {
                   eosio::check(false, "You are already participating or have participated.");
                }
+               n1engine::check_not_closed(get_self(), "accounts"_n, from.value, "You are already participating or have participated.");
 
-
-              
-               bool nft_already_participated = false;
-               for (auto itr = stakers.begin(); itr != stakers.end(); ++itr) {
-                  if (itr->id_nft == transaction_id) {
-                     nft_already_participated = true;
-                     break;  
-                  }
+               if (campaign_itr->userram && !opened) {
+                  eosio::check(false, "Call 'open' before the transfer to pay for your position");
                }
 
-               eosio::check(!nft_already_participated, "This NFT has already participated");
+               n1engine::check_eligible(get_self(), matching_campaign_name, from);
 
 
-               
-               uint64_t places = campaign_itr->places; 
-
               
-               uint64_t count = 0;
-               for (auto itr = stakers.begin(); itr != stakers.end(); ++itr) {
-                  if (itr->campaign == matching_campaign_name) {
-                     count++;
-                  }
-                }
+               auto by_nft = stakers.get_index<"bynft"_n>();
+               eosio::check(by_nft.find(transaction_id) == by_nft.end(), "This NFT has already participated");
+               n1engine::check_not_closed(get_self(), "nfts"_n, transaction_id, "This NFT has already participated");
 
-              
-               if (count >= places) {
+
+               
+               if (campaign_itr->joined >= campaign_itr->places) {
                   eosio::check(false, "There are no places for this campaign.");
                }
 
+               campaignhot.modify(campaign_itr, get_self(), [&](auto& row) {
+                  row.rev = n1engine::next_revision(get_self());
+                  row.joined++;
+               });
+
+
+               
+               bundles_table bundles(get_self(), get_self().value);
+               auto bundle_itr = bundles.find(matching_campaign_name.value);
+               if (bundle_itr != bundles.end() && bundle_itr->nftaccount != name()) {
+                  eosio::check(bundle_itr->nfts_available > 0, "No bundle NFT was found available for this campaign.");
+                  bundles.modify(bundle_itr, get_self(), [&](auto& row) {
+                     row.nfts_available--;
+                  });
+               }
+
 
                
                uint64_t timetoreward = campaign_itr->timetoreward;
                uint64_t claimable_reward = current_time_sec + timetoreward;
 
                
-               if (staker_itr == stakers.end()) {
-               stakers.emplace(get_self(), [&](auto& row) {
+               auto fill_staker = [&](auto& row) {
+                  row.rev = n1engine::next_revision(get_self());
                   row.participant = from;
                   row.campaign = matching_campaign_name;
                   row.join_time = current_time_sec;
@@ -392,8 +1041,15 @@ void nft_transfer(name from, name to, std::vector<uint64_t>& assetids, std::stri
                   row.claimed = false; 
                   row.retired = false; 
                   row.id_nft = transaction_id; 
-               });
-            }
+               };
+
+               if (opened) {
+                  stakers.modify(staker_itr, from, fill_staker);
+               } else {
+                  stakers.emplace(get_self(), fill_staker);
+               }
+
+               n1engine::send_receipt(get_self(), matching_campaign_name, from, asset(), transaction_id, n1engine::receipt_status::joined);
                 
                
             } else {
@@ -411,6 +1067,99 @@ void nft_transfer(name from, name to, std::vector<uint64_t>& assetids, std::stri
 
 private:
 
+  // Validates and stores a new campaign, shared by setcampaign and setcampaigns.
+  void create_campaign(name campaign, uint64_t start, uint64_t finish,
+                       uint64_t timetoreward, name nftaccount, name tokenaccount,
+                       asset reward, uint64_t places, uint64_t memo_expected) {
+    
+    campaigndata_table campaigndata(get_self(), get_self().value);
+    auto existing = campaigndata.find(campaign.value);
+    check(existing == campaigndata.end(), "The campaign already exists in the table campaigndata");
+
+    
+    check(memo_expected > 0, "memo_expected must be a valid number");
+
+    
+    check(places > 0, "Value of 'places' cannot be equal to 0");
+    
+    
+    n1engine::add_memo(get_self(), memo_expected, campaign);
+
+    
+    n1engine::check_schedule(start, finish, timetoreward);
+
+    
+    campaigndata.emplace(get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.campaign = campaign;
+      row.start = start;
+      row.finish = finish;
+      row.timetoreward = timetoreward;
+      row.nftaccount = nftaccount;
+      row.tokenaccount = tokenaccount;
+      row.places = places;
+      row.reward = reward;
+      row.memo_expected = memo_expected;
+    });
+
+    
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    campaignhot.emplace(get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.campaign = campaign;
+      row.start = start;
+      row.finish = finish;
+      row.timetoreward = timetoreward;
+      row.places = places;
+      row.joined = 0;
+      row.nftaccount = nftaccount;
+      row.tokenaccount = tokenaccount;
+      row.reward = reward;
+      row.has_nftdata = false;
+      row.userram = false;
+    });
+
+    n1engine::send_receipt(get_self(), campaign, get_self(), reward, 0, n1engine::receipt_status::created);
+  }
+
+
+  // Registers NFTs held by the contract in the bundle pool of a campaign, deposited by 'from'.
+  template <typename Table, typename Itr>
+  void add_bundle_nfts(Table& bundles, Itr bundle_itr, name from, const std::vector<uint64_t>& assetids) {
+    check(bundle_itr->nftaccount != name(), "The bundle of this campaign has no 'nftaccount'");
+
+    bundlenfts_table bundlenfts(get_self(), get_self().value);
+    for (uint64_t id : assetids) {
+      check(bundlenfts.find(id) == bundlenfts.end(), "This NFT is already in a bundle");
+
+      bundlenfts.emplace(get_self(), [&](auto& row) {
+        row.id = id;
+        row.campaign = bundle_itr->campaign;
+      });
+    }
+
+    bundles.modify(bundle_itr, get_self(), [&](auto& row) {
+      row.nfts_available += assetids.size();
+    });
+
+    for (uint64_t id : assetids) {
+      n1engine::send_receipt(get_self(), bundle_itr->campaign, from, asset(), id, n1engine::receipt_status::deposited);
+    }
+  }
+
+
+  // Takes one NFT out of the bundle pool of a campaign. Availability was reserved at join.
+  uint64_t take_bundle_nft(name campaign) {
+    bundlenfts_table bundlenfts(get_self(), get_self().value);
+    auto by_campaign = bundlenfts.get_index<"bycampaign"_n>();
+    auto nft_itr = by_campaign.lower_bound(campaign.value);
+    check(nft_itr != by_campaign.end() && nft_itr->campaign == campaign, "No bundle NFT was found available for this campaign.");
+
+    uint64_t id = nft_itr->id;
+    by_campaign.erase(nft_itr);
+    return id;
+  }
+
   
   struct [[eosio::table]] staking_config {
     name campaign;
@@ -422,14 +1171,41 @@ private:
     asset reward;
     uint64_t places;
     uint64_t memo_expected;
+    uint64_t rev;
 
     uint64_t primary_key() const { return campaign.value; }
-    uint64_t by_memo() const { return memo_expected; }
+    uint64_t by_rev() const { return rev; }
   };
 
 
 
   
+  // Subset of staking_config and nft_data read on every join, claim and retire.
+  // Kept in sync by setcampaign, addnftdata, delnftdata and delcampaign, and built by migrate
+  // for campaigns created before it existed.
+  struct [[eosio::table]] campaign_hot {
+    name campaign;
+    uint64_t start;
+    uint64_t finish;
+    uint64_t timetoreward;
+    uint64_t places;
+    uint64_t joined;
+    name nftaccount;
+    name tokenaccount;
+    asset reward;
+    name author;
+    name category;
+    checksum256 idata_hash;
+    bool has_nftdata;
+    bool userram;
+    uint64_t rev;
+
+    uint64_t primary_key() const { return campaign.value; }
+    uint64_t by_rev() const { return rev; }
+  };
+
+
+
   struct [[eosio::table]] nft_data {
     name campaign;
     name author;
@@ -440,6 +1216,45 @@ private:
   };
 
 
+  // Extra rewards of a campaign, paid together with staking_config::reward.
+  struct [[eosio::table]] reward_bundle {
+    name campaign;
+    std::vector<extended_asset> tokens;
+    name nftaccount;
+    uint64_t nfts_available;
+
+    uint64_t primary_key() const { return campaign.value; }
+  };
+
+
+  struct [[eosio::table]] bundle_nft {
+    uint64_t id;
+    name campaign;
+
+    uint64_t primary_key() const { return id; }
+    uint64_t by_campaign() const { return campaign.value; }
+  };
+
+
+  struct [[eosio::table]] merkle_drop {
+    name campaign;
+    checksum256 root;
+    name tokenaccount;
+    uint64_t leaves;
+
+    uint64_t primary_key() const { return campaign.value; }
+  };
+
+
+  // Claimed leaves of a merkle_drop, scoped by campaign.
+  struct [[eosio::table]] claimed_bits {
+    uint64_t word;
+    uint64_t bits;
+
+    uint64_t primary_key() const { return word; }
+  };
+
+
 struct [[eosio::table]] staker {
     name participant;
     name campaign;
@@ -448,9 +1263,12 @@ struct [[eosio::table]] staker {
     bool claimed;
     bool retired;
     uint64_t id_nft;
+    uint64_t rev;
 
     uint64_t primary_key() const { return participant.value; }
     uint64_t by_campaign() const { return campaign.value; }
+    uint64_t by_rev() const { return rev; }
+    uint64_t by_nft() const { return id_nft; }
 };
 
 
@@ -458,29 +1276,76 @@ struct [[eosio::table]] staker {
 
  
   typedef eosio::multi_index<"campaigndata"_n, staking_config,
-    indexed_by<"bymemo"_n, const_mem_fun<staking_config, uint64_t, &staking_config::by_memo>>
+    indexed_by<"byrev"_n, const_mem_fun<staking_config, uint64_t, &staking_config::by_rev>>
   > campaigndata_table;
 
 
+  typedef eosio::multi_index<"campaignhot"_n, campaign_hot,
+    indexed_by<"byrev"_n, const_mem_fun<campaign_hot, uint64_t, &campaign_hot::by_rev>>
+  > campaignhot_table;
+
+
   typedef eosio::multi_index<"nftdata"_n, nft_data> nftdata_table;
 
+  typedef eosio::multi_index<"bundles"_n, reward_bundle> bundles_table;
+
+  typedef eosio::multi_index<"bundlenfts"_n, bundle_nft,
+    indexed_by<"bycampaign"_n, const_mem_fun<bundle_nft, uint64_t, &bundle_nft::by_campaign>>
+  > bundlenfts_table;
+
+  typedef eosio::multi_index<"merkledrops"_n, merkle_drop> merkledrops_table;
+
+  typedef eosio::multi_index<"claimedbits"_n, claimed_bits> claimedbits_table;
+
   typedef eosio::multi_index<"stakers"_n, staker,
-    indexed_by<"bycampaign"_n, const_mem_fun<staker, uint64_t, &staker::by_campaign>>
+    indexed_by<"bycampaign"_n, const_mem_fun<staker, uint64_t, &staker::by_campaign>>,
+    indexed_by<"byrev"_n, const_mem_fun<staker, uint64_t, &staker::by_rev>>,
+    indexed_by<"bynft"_n, const_mem_fun<staker, uint64_t, &staker::by_nft>>
   > stakers_table;
 
- 
 
+  // Layouts and indexes deployed before this version, only read by 'migrate'. The first field
+  // added since then is an extension, present only in rows already in the current layout.
+  struct legacy_campaigndata {
+    name campaign;
+    uint64_t start;
+    uint64_t finish;
+    uint64_t timetoreward;
+    name nftaccount;
+    name tokenaccount;
+    asset reward;
+    uint64_t places;
+    uint64_t memo_expected;
+    binary_extension<uint64_t> rev;
 
-   struct [[eosio::table]] sassets {
-    uint64_t id;
-    name owner;
-    name author;
-    name category;
-    string idata;
-   
-    uint64_t primary_key() const { return id; }
+    uint64_t primary_key() const { return campaign.value; }
+    uint64_t by_memo() const { return memo_expected; }
+    bool upgraded() const { return rev.has_value(); }
+  };
+
+
+  struct legacy_staker {
+    name participant;
+    name campaign;
+    uint64_t join_time;
+    uint64_t claimable_reward;
+    bool claimed;
+    bool retired;
+    uint64_t id_nft;
+    binary_extension<uint64_t> rev;
+
+    uint64_t primary_key() const { return participant.value; }
+    uint64_t by_campaign() const { return campaign.value; }
+    bool upgraded() const { return rev.has_value(); }
   };
 
-  typedef multi_index<"sassets"_n, sassets> sassets_table;
+
+  typedef eosio::multi_index<"campaigndata"_n, legacy_campaigndata,
+    indexed_by<"bymemo"_n, const_mem_fun<legacy_campaigndata, uint64_t, &legacy_campaigndata::by_memo>>
+  > legacy_campaigndata_table;
+
+  typedef eosio::multi_index<"stakers"_n, legacy_staker,
+    indexed_by<"bycampaign"_n, const_mem_fun<legacy_staker, uint64_t, &legacy_staker::by_campaign>>
+  > legacy_stakers_table;
   
 };
\ No newline at end of file
@@ -0,0 +1,828 @@
+#include "n1staking.hpp"
+
+using namespace eosio;
+using namespace n1engine;
+
+class [[eosio::contract("n1staking")]] n1staking : public contract {
+public:
+  using contract::contract;
+
+
+// Set up a new stake campaign of any stake/reward kind
+    //campaign - Name of the campaign in the table
+    //filler - Authorized account to add NFT rewards to the campaign
+    //stakekind - 0 if users stake tokens, 1 if users stake an NFT
+    //rewardkind - 0 if users receive tokens, 1 if users receive an NFT
+    //start - UNIX time to start the campaign
+    //finish - UNIX time to end the campaign
+    //timetoreward - UNIX time needed to claim rewards
+    //stakeaccount - Contract that manages the staked tokens or NFT
+    //rewardaccount - Contract that manages the reward tokens or NFT
+    //entry - Number of tokens required for participation (token stake)
+    //reward - Number of reward tokens (token reward)
+    //return_entry - Indicates whether the stake will be returned together with the reward
+    //author - Expected nft author information (NFT stake)
+    //category - Expected nft category information (NFT stake)
+    //idata - Expected nft idata information (NFT stake)
+    //places - Maximum number of participants in the campaign
+    //memo_expected - Used as a match for the contract logics
+
+  [[eosio::action]]
+  void newcampaign(name campaign, name filler, uint8_t stakekind, uint8_t rewardkind,
+                   uint64_t start, uint64_t finish, uint64_t timetoreward,
+                   name stakeaccount, name rewardaccount, asset entry, asset reward,
+                   bool return_entry, name author, name category, std::string idata, uint64_t places,
+                   uint64_t memo_expected) {
+    require_auth(get_self());
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    check(campaigns.find(campaign.value) == campaigns.end(), "The campaign already exists in the table campaigns");
+
+    check(stakekind <= kind::nft && rewardkind <= kind::nft, "Invalid stake or reward kind");
+    check(memo_expected > 0, "memo_expected must be a valid number");
+    check(places > 0, "Value of 'places' cannot be equal to 0");
+
+    add_memo(get_self(), memo_expected, campaign);
+
+    check_schedule(start, finish, timetoreward);
+
+    if (stakekind == kind::token) {
+      check(entry.is_valid() && entry.amount > 0, "'entry' must be a positive amount for token stakes");
+    }
+
+    if (rewardkind == kind::token) {
+      check(reward.is_valid() && reward.amount > 0, "'reward' must be a positive amount for token rewards");
+    }
+
+    campaigns.emplace(get_self(), [&](auto& row) {
+      row.campaign = campaign;
+      row.filler = filler;
+      row.stakekind = stakekind;
+      row.rewardkind = rewardkind;
+      row.start = start;
+      row.finish = finish;
+      row.timetoreward = timetoreward;
+      row.stakeaccount = stakeaccount;
+      row.rewardaccount = rewardaccount;
+      row.entry = entry;
+      row.reward = reward;
+      row.return_entry = return_entry;
+      row.author = author;
+      row.category = category;
+      row.idata_hash = sha256(idata.data(), idata.size());
+      row.places = places;
+      row.joined = 0;
+      row.available_rewards = 0;
+      row.memo_expected = memo_expected;
+      row.autorenew = false;
+      row.deferred = false;
+    });
+
+    send_receipt(get_self(), campaign, get_self(), reward, 0, receipt_status::created);
+  }
+
+
+  // Makes positions roll into the next epoch instead of ending at 'timetoreward'.
+  // Each complete epoch of 'timetoreward' seconds pays 'reward' once. Only before the campaign starts.
+    //campaign - The campaign to make auto-renewing
+
+  [[eosio::action]]
+  void setautorenew(name campaign) {
+    require_auth(get_self());
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    auto campaign_itr = campaigns.find(campaign.value);
+    check(campaign_itr != campaigns.end(), "There is no campaign with this name");
+
+    check(now_sec() < campaign_itr->start, "The campaign has already started");
+    check(!campaign_itr->deferred, "Deferred campaigns cannot renew");
+    check(campaign_itr->rewardkind == kind::token, "Only token rewards can renew");
+    check(campaign_itr->timetoreward > 0, "Value of 'timetoreward' cannot be equal to 0");
+
+    tiers_table tiers(get_self(), campaign.value);
+    check(tiers.begin() == tiers.end(), "Auto-renewing campaigns have no tiers");
+
+    campaigns.modify(campaign_itr, get_self(), [&](auto& row) {
+      row.autorenew = true;
+    });
+  }
+
+
+  // Makes matured positions wait for 'settle' instead of being claimed by each user.
+  // Only before the campaign starts.
+    //campaign - The campaign to settle in batches
+
+  [[eosio::action]]
+  void setdeferred(name campaign) {
+    require_auth(get_self());
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    auto campaign_itr = campaigns.find(campaign.value);
+    check(campaign_itr != campaigns.end(), "There is no campaign with this name");
+
+    check(now_sec() < campaign_itr->start, "The campaign has already started");
+    check(!campaign_itr->autorenew, "Auto-renewing campaigns are claimed per epoch");
+
+    // settle resumes after the cursor's participant within its second, so a position must
+    // never mature in the same second it joins.
+    check(campaign_itr->timetoreward > 0, "Deferred campaigns need a 'timetoreward' above 0");
+    tiers_table tiers(get_self(), campaign.value);
+    for (const auto& tier : tiers) {
+      check(tier.timetoreward > 0, "Deferred campaigns need a 'timetoreward' above 0 in every tier");
+    }
+
+    campaigns.modify(campaign_itr, get_self(), [&](auto& row) {
+      row.deferred = true;
+    });
+
+    cursors_table cursors(get_self(), get_self().value);
+    if (cursors.find(campaign.value) == cursors.end()) {
+      cursors.emplace(get_self(), [&](auto& row) {
+        row.campaign = campaign;
+        row.claimable_reward = 0;
+        row.participant = name();
+        row.settled = 0;
+      });
+    }
+  }
+
+
+  // Pays up to 'max_rows' matured positions of a deferred campaign, in the order they matured.
+  // Anyone can call it; the cursor keeps the progress between calls.
+    //campaign - Deferred campaign to settle
+    //max_rows - Maximum number of positions visited in this call
+
+  [[eosio::action]]
+  void settle(name campaign, uint64_t max_rows) {
+    check(max_rows > 0, "Value of 'max_rows' cannot be equal to 0");
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    auto campaign_itr = campaigns.find(campaign.value);
+    check(campaign_itr != campaigns.end(), "There is no campaign with this name");
+    check(campaign_itr->deferred, "This campaign is not settled in batches");
+
+    cursors_table cursors(get_self(), get_self().value);
+    auto cursor_itr = cursors.find(campaign.value);
+    check(cursor_itr != cursors.end(), "The campaign has no settlement cursor");
+
+    uint64_t cursor_time = cursor_itr->claimable_reward;
+    name cursor_participant = cursor_itr->participant;
+
+    stakers_table stakers(get_self(), get_self().value);
+    auto by_maturity = stakers.get_index<"bymaturity"_n>();
+    auto staker_itr = by_maturity.lower_bound(staker_row::maturity_key(campaign, cursor_time));
+
+    // Positions maturing in the cursor's second were visited up to the cursor's participant.
+    while (staker_itr != by_maturity.end() && staker_itr->campaign == campaign &&
+           staker_itr->claimable_reward == cursor_time && staker_itr->participant.value <= cursor_participant.value) {
+      staker_itr++;
+    }
+
+    uint64_t current_time_sec = now_sec();
+    uint64_t visited = 0;
+    uint64_t settled = 0;
+
+    while (staker_itr != by_maturity.end() && staker_itr->campaign == campaign &&
+           staker_itr->claimable_reward <= current_time_sec && visited < max_rows) {
+      if (!staker_itr->claimed && !staker_itr->retired) {
+        uint64_t id_reward = pay_position(*campaign_itr, *staker_itr);
+
+        by_maturity.modify(staker_itr, get_self(), [&](auto& row) {
+          row.claimed = true;
+          row.id_reward = id_reward;
+        });
+        settled++;
+      }
+
+      cursor_time = staker_itr->claimable_reward;
+      cursor_participant = staker_itr->participant;
+      visited++;
+      staker_itr++;
+    }
+
+    check(visited > 0, "No matured position left to settle");
+
+    cursors.modify(cursor_itr, get_self(), [&](auto& row) {
+      row.claimable_reward = cursor_time;
+      row.participant = cursor_participant;
+      row.settled += settled;
+    });
+  }
+
+
+ // Allows you to delete an entry from campaigns.
+    //campaign - Campaign you want to delete from table.
+    //memo - "Confirm" for security
+
+[[eosio::action]]
+void delcampaign(name campaign, std::string memo) {
+    require_auth(get_self());
+
+    check(memo == "confirm", "Fail");
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    auto campaign_itr = campaigns.find(campaign.value);
+    check(campaign_itr != campaigns.end(), "The campaign does not exist in the table campaigns");
+
+    erase_memo(get_self(), campaign_itr->memo_expected);
+    set_allowlist(get_self(), campaign, checksum256());
+    campaigns.erase(campaign_itr);
+
+    tiers_table tiers(get_self(), campaign.value);
+    auto tier_itr = tiers.begin();
+    while (tier_itr != tiers.end()) {
+      tier_itr = tiers.erase(tier_itr);
+    }
+
+    cursors_table cursors(get_self(), get_self().value);
+    auto cursor_itr = cursors.find(campaign.value);
+    if (cursor_itr != cursors.end()) {
+      cursors.erase(cursor_itr);
+    }
+
+    send_receipt(get_self(), campaign, get_self(), asset(), 0, receipt_status::deleted);
+}
+
+
+// No-op notification sent by the contract on every campaign transition. See n1engine::send_receipt.
+
+[[eosio::action]]
+void receipt(name campaign, name account, asset quantity, uint64_t id, uint8_t status, uint32_t timestamp) {
+    require_auth(get_self());
+}
+
+
+  // Allows the reward to be claimed after the stake time has expired
+    //user - user claiming his reward
+
+[[eosio::action]]
+void claimreward(name user) {
+    require_auth(user);
+
+    stakers_table stakers(get_self(), get_self().value);
+    auto staker_itr = stakers.find(user.value);
+    check(staker_itr != stakers.end(), "You are not registered as a participant in any campaign");
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    auto campaign_itr = campaigns.find(staker_itr->campaign.value);
+    check(campaign_itr != campaigns.end(), "Corresponding campaign was not found in the campaigns table.");
+
+    if (campaign_itr->autorenew) {
+      check(!staker_itr->claimed && !staker_itr->retired, "Already claimed or withdrawn from this campaign");
+
+      uint64_t completed;
+      uint64_t owed = pay_epochs(*campaign_itr, *staker_itr, user, completed);
+      bool finished = now_sec() >= campaign_itr->finish;
+      check(owed > 0 || finished, "No complete epoch to claim yet");
+
+      if (finished && campaign_itr->return_entry) {
+        dispatch(*campaign_itr, [&](auto kinds) {
+          decltype(kinds)::refund(get_self(), campaign_itr->stakeaccount, user,
+                                   campaign_itr->entry, staker_itr->id_staked, "Returned entry");
+        });
+      }
+
+      stakers.modify(staker_itr, get_self(), [&](auto& row) {
+        row.epoch = completed;
+        row.claimed = finished;
+      });
+
+      send_receipt(get_self(), campaign_itr->campaign, user, campaign_itr->reward * owed, staker_itr->id_staked, receipt_status::claimed);
+      return;
+    }
+
+    check(!campaign_itr->deferred, "Rewards of this campaign are paid by 'settle'");
+    check_claimable(staker_itr->claimed, staker_itr->retired, staker_itr->claimable_reward);
+
+    uint64_t id_reward = pay_position(*campaign_itr, *staker_itr);
+
+    stakers.modify(staker_itr, get_self(), [&](auto& row) {
+      row.claimed = true;
+      row.id_reward = id_reward;
+    });
+}
+
+
+  // Allows withdrawing from campaign only if stake time has not been completed
+    //user - user who withdraws his participation
+
+[[eosio::action]]
+void retirestake(name user) {
+    require_auth(user);
+
+    stakers_table stakers(get_self(), get_self().value);
+    auto staker_itr = stakers.find(user.value);
+    check(staker_itr != stakers.end(), "You are not registered as a participant in any campaign");
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    auto campaign_itr = campaigns.find(staker_itr->campaign.value);
+    check(campaign_itr != campaigns.end(), "Corresponding campaign was not found in the campaigns table.");
+
+    uint64_t completed = staker_itr->epoch;
+    if (campaign_itr->autorenew) {
+      // Leaving an auto-renewing campaign is allowed until it finishes and settles the complete epochs.
+      // After the finish the position ends through claimreward, which applies 'return_entry'.
+      check(!staker_itr->claimed && !staker_itr->retired, "Already claimed or withdrawn from this campaign");
+      check(now_sec() < campaign_itr->finish, "The campaign has finished, claim your reward");
+      pay_epochs(*campaign_itr, *staker_itr, user, completed);
+    } else {
+      check_retirable(staker_itr->claimed, staker_itr->retired, staker_itr->claimable_reward);
+    }
+
+    dispatch(*campaign_itr, [&](auto kinds) {
+      decltype(kinds)::refund(get_self(), campaign_itr->stakeaccount, user,
+                               campaign_itr->entry, staker_itr->id_staked, "Returned entry");
+    });
+
+    campaigns.modify(campaign_itr, get_self(), [&](auto& row) {
+      row.joined--;
+      if (row.rewardkind == kind::nft) {
+        row.available_rewards++;
+      }
+    });
+
+    if (staker_itr->tier != 0) {
+      tiers_table tiers(get_self(), campaign_itr->campaign.value);
+      auto tier_itr = tiers.find(staker_itr->tier);
+      if (tier_itr != tiers.end()) {
+        tiers.modify(tier_itr, get_self(), [&](auto& row) {
+          row.joined--;
+        });
+      }
+    }
+
+    stakers.modify(staker_itr, get_self(), [&](auto& row) {
+      row.retired = true;
+      row.epoch = completed;
+    });
+
+    send_receipt(get_self(), campaign_itr->campaign, user, campaign_itr->entry, staker_itr->id_staked, receipt_status::retired);
+}
+
+
+ // Allows you to delete all "Stakers" of the same campaign.
+    //campaign - Campaign in which you want to delete all stakers
+    //memo - "Confirm" for security
+
+[[eosio::action]]
+void delstakers(name campaign, std::string memo) {
+    require_auth(get_self());
+
+    check(memo == "confirm", "Fail");
+
+    stakers_table stakers(get_self(), get_self().value);
+    auto by_campaign = stakers.get_index<"bycampaign"_n>();
+    auto staker_itr = by_campaign.lower_bound(campaign.value);
+    while (staker_itr != by_campaign.end() && staker_itr->campaign == campaign) {
+      staker_itr = by_campaign.erase(staker_itr);
+    }
+}
+
+
+ // Allows you to delete all "Rewards" of the same campaign.
+    //campaign - Campaign in which you want to delete all rewards
+    //memo - "Confirm" for security
+
+[[eosio::action]]
+void clearrewards(name campaign, std::string memo) {
+    require_auth(get_self());
+
+    check(memo == "confirm", "Fail");
+
+    rewards_table rewards(get_self(), get_self().value);
+    auto by_campaign = rewards.get_index<"bycampaign"_n>();
+    auto reward_itr = by_campaign.lower_bound(campaign.value);
+    while (reward_itr != by_campaign.end() && reward_itr->campaign == campaign) {
+      reward_itr = by_campaign.erase(reward_itr);
+    }
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    auto campaign_itr = campaigns.find(campaign.value);
+    if (campaign_itr != campaigns.end()) {
+      campaigns.modify(campaign_itr, get_self(), [&](auto& row) {
+        row.available_rewards = 0;
+      });
+    }
+}
+
+
+// Adds or updates a lock tier of a campaign, selected with "<memo_expected>:<tier>" in the transfer memo
+    //campaign - Campaign the tier belongs to
+    //tier - Number of the tier, greater than 0
+    //timetoreward - UNIX time needed to claim rewards in this tier
+    //reward - Number of reward tokens in this tier (token reward)
+    //places - Maximum number of participants in this tier
+
+[[eosio::action]]
+void settier(name campaign, uint64_t tier, uint64_t timetoreward, asset reward, uint64_t places) {
+    require_auth(get_self());
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    auto campaign_itr = campaigns.find(campaign.value);
+    check(campaign_itr != campaigns.end(), "There is no campaign with this name");
+
+    check(!campaign_itr->autorenew, "Auto-renewing campaigns have no tiers");
+    check(tier > 0, "Tier 0 is the campaign itself");
+    check(places > 0, "Value of 'places' cannot be equal to 0");
+    check(timetoreward < (campaign_itr->finish - campaign_itr->start), "Duration is greater to active time");
+    check(!campaign_itr->deferred || timetoreward > 0, "Deferred campaigns need a 'timetoreward' above 0 in every tier");
+
+    if (campaign_itr->rewardkind == kind::token) {
+      check(reward.is_valid() && reward.amount > 0, "'reward' must be a positive amount for token rewards");
+      check(reward.symbol == campaign_itr->reward.symbol, "Tier reward symbol does not match the campaign reward");
+    }
+
+    tiers_table tiers(get_self(), campaign.value);
+    auto tier_itr = tiers.find(tier);
+
+    if (tier_itr == tiers.end()) {
+      tiers.emplace(get_self(), [&](auto& row) {
+        row.tier = tier;
+        row.timetoreward = timetoreward;
+        row.reward = reward;
+        row.places = places;
+        row.joined = 0;
+      });
+    } else {
+      check(places >= tier_itr->joined, "Places cannot be lower than the current participants of the tier");
+      check(tier_itr->joined == 0 || reward == tier_itr->reward, "The reward of a tier with participants cannot change");
+
+      tiers.modify(tier_itr, get_self(), [&](auto& row) {
+        row.timetoreward = timetoreward;
+        row.reward = reward;
+        row.places = places;
+      });
+    }
+}
+
+
+ // Allows you to delete a tier without participants.
+    //campaign - Campaign the tier belongs to
+    //tier - Number of the tier
+
+[[eosio::action]]
+void deltier(name campaign, uint64_t tier) {
+    require_auth(get_self());
+
+    tiers_table tiers(get_self(), campaign.value);
+    auto tier_itr = tiers.find(tier);
+    check(tier_itr != tiers.end(), "The tier does not exist in the table tiers");
+    check(tier_itr->joined == 0, "The tier has participants");
+
+    tiers.erase(tier_itr);
+}
+
+
+// Restricts a campaign to the accounts of a Merkle tree
+    //campaign - Campaign to restrict
+    //root - Merkle root of the leaves sha256(pack(account)), empty to open the campaign to everyone
+
+[[eosio::action]]
+void setallowlist(name campaign, checksum256 root) {
+    require_auth(get_self());
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    check(campaigns.find(campaign.value) != campaigns.end(), "There is no campaign with this name");
+
+    set_allowlist(get_self(), campaign, root);
+}
+
+
+// Proves that 'user' is in the allowlist of a campaign. Sent in the same transaction before the stake transfer.
+    //user - Account joining the campaign
+    //campaign - Campaign with an allowlist
+    //proof - Merkle proof of the leaf sha256(pack(user))
+
+[[eosio::action]]
+void prove(name user, name campaign, std::vector<checksum256> proof) {
+    require_auth(user);
+    add_pass(get_self(), campaign, user, proof);
+}
+
+
+// Exports rows of 'campaigns', 'tiers', 'allowlists', 'stakers' or 'rewards' in packed pages for 'importrows'.
+    //table - Table to read
+    //scope - Campaign of the 'tiers' rows, ignored by the other tables
+    //lower_key - First primary key of the page, 'next_key' of the previous page
+    //limit - Maximum number of rows in the page
+
+[[eosio::action, eosio::read_only]]
+snapshot_page exportrows(name table, name scope, uint64_t lower_key, uint32_t limit) {
+    if (table == "campaigns"_n) {
+      campaigns_table campaigns(get_self(), get_self().value);
+      return export_rows(campaigns, lower_key, limit);
+    }
+    if (table == "tiers"_n) {
+      tiers_table tiers(get_self(), scope.value);
+      return export_rows(tiers, lower_key, limit);
+    }
+    if (table == "allowlists"_n) {
+      allowlists_table allowlists(get_self(), get_self().value);
+      return export_rows(allowlists, lower_key, limit);
+    }
+    if (table == "stakers"_n) {
+      stakers_table stakers(get_self(), get_self().value);
+      return export_rows(stakers, lower_key, limit);
+    }
+
+    check(table == "rewards"_n, "Only campaigns, tiers, allowlists, stakers and rewards can be exported");
+    rewards_table rewards(get_self(), get_self().value);
+    return export_rows(rewards, lower_key, limit);
+}
+
+
+#ifdef N1STAKING_IMPORT
+// Loads a page produced by 'exportrows' to set up test and benchmark environments
+// without replaying transfers. Only compiled with -DN1STAKING_IMPORT, never in production.
+    //table - Table the rows belong to
+    //scope - Campaign of the 'tiers' rows, ignored by the other tables
+    //rows - The 'rows' of a snapshot_page
+
+[[eosio::action]]
+void importrows(name table, name scope, std::vector<char> rows) {
+    require_auth(get_self());
+
+    if (table == "campaigns"_n) {
+      campaigns_table campaigns(get_self(), get_self().value);
+      cursors_table cursors(get_self(), get_self().value);
+
+      for (const auto& campaign : unpack<std::vector<campaign_row>>(rows)) {
+        add_memo(get_self(), campaign.memo_expected, campaign.campaign);
+        campaigns.emplace(get_self(), [&](auto& row) {
+          row = campaign;
+        });
+
+        // The settlement cursor of deferred campaigns restarts at their first position.
+        if (campaign.deferred) {
+          cursors.emplace(get_self(), [&](auto& row) {
+            row.campaign = campaign.campaign;
+            row.claimable_reward = 0;
+            row.participant = name();
+            row.settled = 0;
+          });
+        }
+      }
+    } else if (table == "tiers"_n) {
+      tiers_table tiers(get_self(), scope.value);
+      for (const auto& tier : unpack<std::vector<tier_row>>(rows)) {
+        tiers.emplace(get_self(), [&](auto& row) {
+          row = tier;
+        });
+      }
+    } else if (table == "allowlists"_n) {
+      for (const auto& allowlist : unpack<std::vector<allowlist_row>>(rows)) {
+        set_allowlist(get_self(), allowlist.campaign, allowlist.root);
+      }
+    } else if (table == "stakers"_n) {
+      stakers_table stakers(get_self(), get_self().value);
+      for (const auto& staker : unpack<std::vector<staker_row>>(rows)) {
+        stakers.emplace(get_self(), [&](auto& row) {
+          row = staker;
+        });
+      }
+    } else {
+      check(table == "rewards"_n, "Only campaigns, tiers, allowlists, stakers and rewards can be imported");
+      rewards_table rewards(get_self(), get_self().value);
+      for (const auto& reward : unpack<std::vector<reward_row>>(rows)) {
+        rewards.emplace(get_self(), [&](auto& row) {
+          row = reward;
+        });
+      }
+    }
+}
+#endif
+
+
+//Logic to receive tokens and register the sender as a staker.
+
+[[eosio::on_notify("niceonetoken::transfer")]]
+void token_transfer(name from, name to, asset quantity, std::string memo) {
+    if (to != get_self()) {
+      return;
+    }
+
+    // Token transfers without a campaign memo, like plain funding, are accepted untouched.
+    uint64_t memo_value;
+    uint64_t tier;
+    if (!parse_memo(memo, memo_value, tier)) {
+      return;
+    }
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    auto campaign_itr = campaigns.find(find_memo(get_self(), memo_value).value);
+    check(campaign_itr != campaigns.end(), "The campaign does not exist");
+
+    if (from == campaign_itr->filler && now_sec() < campaign_itr->start) {
+      check(campaign_itr->rewardkind == kind::token, "This campaign does not reward tokens");
+      check(get_first_receiver() == campaign_itr->rewardaccount, "Unexpected issuer contract");
+      send_receipt(get_self(), campaign_itr->campaign, from, quantity, 0, receipt_status::deposited);
+      return;
+    }
+
+    check(campaign_itr->stakekind == kind::token, "This campaign does not accept tokens");
+    check(get_first_receiver() == campaign_itr->stakeaccount, "Invalid token contract");
+    check(quantity == campaign_itr->entry, "Number of tokens does not match specified entry");
+
+    join(campaigns, campaign_itr, from, 0, tier);
+}
+
+
+//Logic to receive NFTs, either as campaign rewards from the filler or as a stake.
+
+[[eosio::on_notify("simpleassets::transfer")]]
+void nft_transfer(name from, name to, std::vector<uint64_t>& assetids, std::string memo) {
+    if (to != get_self()) {
+      return;
+    }
+
+    uint64_t memo_value;
+    uint64_t tier;
+    check(parse_memo(memo, memo_value, tier), "Memo must be a campaign number");
+
+    campaigns_table campaigns(get_self(), get_self().value);
+    auto campaign_itr = campaigns.find(find_memo(get_self(), memo_value).value);
+    check(campaign_itr != campaigns.end(), "The campaign does not exist");
+
+    if (from == campaign_itr->filler && now_sec() < campaign_itr->start) {
+      check(campaign_itr->rewardkind == kind::nft, "This campaign does not reward NFTs");
+      check(get_first_receiver() == campaign_itr->rewardaccount, "Unexpected issuer contract");
+      add_rewards(campaigns, campaign_itr, assetids);
+      return;
+    }
+
+    check(campaign_itr->stakekind == kind::nft, "This campaign does not accept NFTs");
+    check(get_first_receiver() == campaign_itr->stakeaccount, "Invalid nft contract");
+    check(assetids.size() == 1, "Only one ID was expected");
+    uint64_t id_staked = assetids[0];
+
+    sassets_table sassets(campaign_itr->stakeaccount, get_self().value);
+    auto asset_itr = sassets.find(id_staked);
+    check(asset_itr != sassets.end(), "The asset_id was not found in the table 'sassets'.");
+    check(asset_itr->author == campaign_itr->author, "The 'author' data do not match");
+    check(asset_itr->category == campaign_itr->category, "The 'category' data do not match");
+    check(sha256(asset_itr->idata.data(), asset_itr->idata.size()) == campaign_itr->idata_hash, "The 'idata' data do not match");
+
+    stakers_table stakers(get_self(), get_self().value);
+    auto by_staked = stakers.get_index<"bystaked"_n>();
+    check(by_staked.find(id_staked) == by_staked.end(), "This NFT has already participated");
+
+    join(campaigns, campaign_itr, from, id_staked, tier);
+}
+
+
+
+private:
+
+  // Calls 'fn' with the engine instance matching the campaign kinds.
+  template <typename Fn>
+  static void dispatch(const campaign_row& row, Fn&& fn) {
+    if (row.stakekind == kind::token && row.rewardkind == kind::token) {
+      fn(engine<token_kind, token_kind>{});
+    } else if (row.stakekind == kind::token && row.rewardkind == kind::nft) {
+      fn(engine<token_kind, nft_kind>{});
+    } else if (row.stakekind == kind::nft && row.rewardkind == kind::token) {
+      fn(engine<nft_kind, token_kind>{});
+    } else {
+      fn(engine<nft_kind, nft_kind>{});
+    }
+  }
+
+
+  // Registers 'user' as a staker once the stake itself has been validated.
+  template <typename Itr>
+  void join(campaigns_table& campaigns, Itr campaign_itr, name user, uint64_t id_staked, uint64_t tier) {
+    check_active(campaign_itr->start, campaign_itr->finish);
+
+    stakers_table stakers(get_self(), get_self().value);
+    check(stakers.find(user.value) == stakers.end(), "You are already participating or have participated.");
+
+    check_eligible(get_self(), campaign_itr->campaign, user);
+
+    check(campaign_itr->joined < campaign_itr->places, "There are no places for this campaign.");
+
+    if (campaign_itr->rewardkind == kind::nft) {
+      check(campaign_itr->available_rewards > 0, "No reward was found available for this campaign.");
+    }
+
+    uint64_t current_time_sec = now_sec();
+
+    uint64_t timetoreward = campaign_itr->timetoreward;
+    uint64_t epoch = 0;
+    if (campaign_itr->autorenew) {
+      // The epoch the user joins in is partial, accrual starts at the next one.
+      check(tier == 0, "Auto-renewing campaigns have no tiers");
+      epoch = epoch_at(campaign_itr->start, campaign_itr->finish, timetoreward, current_time_sec) + 1;
+      timetoreward = campaign_itr->start + (epoch + 1) * timetoreward - current_time_sec;
+    }
+
+    if (tier != 0) {
+      tiers_table tiers(get_self(), campaign_itr->campaign.value);
+      auto tier_itr = tiers.find(tier);
+      check(tier_itr != tiers.end(), "This tier does not exist for the campaign");
+      check(tier_itr->joined < tier_itr->places, "There are no places for this tier.");
+
+      tiers.modify(tier_itr, get_self(), [&](auto& row) {
+        row.joined++;
+      });
+      timetoreward = tier_itr->timetoreward;
+    }
+
+    campaigns.modify(campaign_itr, get_self(), [&](auto& row) {
+      row.joined++;
+      if (row.rewardkind == kind::nft) {
+        row.available_rewards--;
+      }
+    });
+
+    stakers.emplace(get_self(), [&](auto& row) {
+      row.participant = user;
+      row.campaign = campaign_itr->campaign;
+      row.join_time = current_time_sec;
+      row.claimable_reward = current_time_sec + timetoreward;
+      row.claimed = false;
+      row.retired = false;
+      row.id_staked = id_staked;
+      row.id_reward = 0;
+      row.tier = tier;
+      row.epoch = epoch;
+    });
+
+    send_receipt(get_self(), campaign_itr->campaign, user, campaign_itr->entry, id_staked, receipt_status::joined);
+  }
+
+
+  // Pays the reward of a matured position (and its stake, if returned). Returns the NFT reward id, or 0.
+  uint64_t pay_position(const campaign_row& campaign, const staker_row& staker) {
+    uint64_t id_reward = 0;
+    if (campaign.rewardkind == kind::nft) {
+      id_reward = take_reward(campaign.campaign);
+    }
+
+    asset reward = campaign.reward;
+    if (staker.tier != 0) {
+      tiers_table tiers(get_self(), campaign.campaign.value);
+      reward = tiers.get(staker.tier, "Corresponding tier was not found in the tiers table.").reward;
+    }
+
+    dispatch(campaign, [&](auto kinds) {
+      decltype(kinds)::settle(get_self(), campaign.stakeaccount, campaign.rewardaccount, staker.participant,
+                               campaign.entry, staker.id_staked, campaign.return_entry,
+                               reward, id_reward);
+    });
+
+    send_receipt(get_self(), campaign.campaign, staker.participant, reward, id_reward, receipt_status::claimed);
+    return id_reward;
+  }
+
+
+  // Pays in one transfer every epoch an auto-renewing position completed since its last claim.
+  // Returns the number of epochs paid and sets 'completed' to the new epoch of the position.
+  uint64_t pay_epochs(const campaign_row& campaign, const staker_row& staker, name user, uint64_t& completed) {
+    completed = epoch_at(campaign.start, campaign.finish, campaign.timetoreward, now_sec());
+    if (completed <= staker.epoch) {
+      completed = staker.epoch;
+      return 0;
+    }
+
+    uint64_t owed = completed - staker.epoch;
+    send_tokens(get_self(), campaign.rewardaccount, user, campaign.reward * owed, "Reward claimed");
+    return owed;
+  }
+
+
+  // Adds NFTs sent by the filler to the reward pool of a campaign.
+  template <typename Itr>
+  void add_rewards(campaigns_table& campaigns, Itr campaign_itr, const std::vector<uint64_t>& assetids) {
+    rewards_table rewards(get_self(), get_self().value);
+    for (uint64_t id : assetids) {
+      rewards.emplace(get_self(), [&](auto& row) {
+        row.id = id;
+        row.campaign = campaign_itr->campaign;
+        row.available = true;
+        row.delivered = false;
+      });
+    }
+
+    campaigns.modify(campaign_itr, get_self(), [&](auto& row) {
+      row.available_rewards += assetids.size();
+    });
+
+    for (uint64_t id : assetids) {
+      send_receipt(get_self(), campaign_itr->campaign, campaign_itr->filler, asset(), id, receipt_status::deposited);
+    }
+  }
+
+
+  // Takes the first NFT reward of a campaign out of the rewards table. Delivered rewards
+  // are erased, so the first row of the campaign is always available.
+  uint64_t take_reward(name campaign) {
+    rewards_table rewards(get_self(), get_self().value);
+    auto by_campaign = rewards.get_index<"bycampaign"_n>();
+    auto reward_itr = by_campaign.lower_bound(campaign.value);
+    check(reward_itr != by_campaign.end() && reward_itr->campaign == campaign, "No reward was found available for this campaign.");
+
+    uint64_t id = reward_itr->id;
+    by_campaign.erase(reward_itr);
+    return id;
+  }
+};
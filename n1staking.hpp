@@ -0,0 +1,714 @@
+#pragma once
+
+#include <eosio/eosio.hpp>
+#include <eosio/asset.hpp>
+#include <eosio/binary_extension.hpp>
+#include <eosio/crypto.hpp>
+#include <eosio/singleton.hpp>
+#include <eosio/system.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Shared campaign engine used by n1nfttotoken, n1tokentonft and n1staking.
+//
+// Every contract uses the transfer primitives, the lifecycle checks, memos, allowlists,
+// revisions, receipts, snapshots and closed positions defined here. Only n1staking keeps its
+// campaigns, stakers and rewards in the engine tables at the end of this file. n1nfttotoken
+// and n1tokentonft keep their own tables, because their names and fields are read by existing
+// front-ends and indexers ('migrate' only rewrites rows within those tables). Tiers,
+// auto-renewing epochs and deferred settlement need the engine tables, so only n1staking has them.
+namespace n1engine {
+
+using namespace eosio;
+
+// Current block time in seconds.
+inline uint64_t now_sec() {
+  time_point_sec current_time = current_time_point();
+  return current_time.sec_since_epoch();
+}
+
+
+// Sends tokens held by the contract.
+inline void send_tokens(name self, name token_account, name to, const asset& quantity, const std::string& memo) {
+  action(
+    permission_level{self, "active"_n},
+    token_account,
+    "transfer"_n,
+    std::make_tuple(self, to, quantity, memo)
+  ).send();
+}
+
+
+// Sends several NFTs of the same contract held by the contract in a single transfer.
+inline void send_nfts(name self, name nft_account, name to, const std::vector<uint64_t>& assetids, const std::string& memo) {
+  action(
+    permission_level{self, "active"_n},
+    nft_account,
+    "transfer"_n,
+    std::make_tuple(self, to, assetids, memo)
+  ).send();
+}
+
+
+// Sends a single NFT held by the contract.
+inline void send_nft(name self, name nft_account, name to, uint64_t id, const std::string& memo) {
+  std::vector<uint64_t> assetids;
+  assetids.push_back(id);
+
+  send_nfts(self, nft_account, to, assetids, memo);
+}
+
+
+// Adds 'quantity' to a list of token rewards, merging it into the entry with the same contract and symbol.
+inline void merge_asset(std::vector<extended_asset>& assets, const extended_asset& quantity) {
+  for (auto& entry : assets) {
+    if (entry.contract == quantity.contract && entry.quantity.symbol == quantity.quantity.symbol) {
+      entry.quantity += quantity.quantity;
+      return;
+    }
+  }
+  assets.push_back(quantity);
+}
+
+
+// Sends a merged list of token rewards, one transfer per contract and symbol.
+inline void send_bundle(name self, name to, const std::vector<extended_asset>& assets, const std::string& memo) {
+  for (const auto& entry : assets) {
+    send_tokens(self, entry.contract, to, entry.quantity, memo);
+  }
+}
+
+
+// Last revision handed out by next_revision, one per contract.
+struct [[eosio::table]] revision_state {
+  uint64_t last = 0;
+};
+
+typedef eosio::singleton<"revision"_n, revision_state> revision_singleton;
+
+
+// Returns a new contract-wide revision. Tracked rows store it on every emplace and
+// modify so indexers can read only what changed since their last cursor.
+inline uint64_t next_revision(name self) {
+  revision_singleton revision(self, self.value);
+  revision_state state = revision.get_or_default();
+  state.last++;
+  revision.set(state, self);
+  return state.last;
+}
+
+
+// Progress of the 'migrate' actions of n1nfttotoken and n1tokentonft: the table being
+// migrated (its position in the contract's migration order) and the next primary key.
+struct [[eosio::table]] migration_state {
+  uint8_t table = 0;
+  uint64_t next_key = 0;
+};
+
+typedef eosio::singleton<"migration"_n, migration_state> migration_singleton;
+
+
+// Rewrites rows stored with the layout deployed before this version, starting at 'next_key'.
+// 'legacy' reads with the old layout and indexes, so erasing through it also removes the old
+// secondary entries; 'upgrade' emplaces the row again with the current layout and indexes.
+// Rows that already have the current layout (upgraded() is true) are skipped.
+// Every visited row uses one unit of 'budget'. Returns true when the table is done.
+template <typename LegacyTable, typename Fn>
+bool migrate_rows(LegacyTable& legacy, uint64_t& next_key, uint64_t& budget, Fn&& upgrade) {
+  auto itr = legacy.lower_bound(next_key);
+  while (itr != legacy.end() && budget > 0) {
+    budget--;
+    auto row = *itr;
+    next_key = row.primary_key() + 1;
+
+    if (row.upgraded()) {
+      ++itr;
+      continue;
+    }
+
+    itr = legacy.erase(itr);
+    upgrade(row);
+  }
+  return itr == legacy.end();
+}
+
+
+// A row changed after a given revision, as returned by the 'changes' actions.
+// 'erased' rows no longer exist and should be dropped by the reader.
+struct row_change {
+  name table;
+  uint64_t key;
+  uint64_t rev;
+  bool erased;
+};
+
+
+// Last erase of a row of a table reported by 'changes'. There is one row per table and key,
+// so a key erased again only moves to a newer revision.
+struct [[eosio::table]] erased_row {
+  uint64_t id;
+  name table;
+  uint64_t key;
+  uint64_t rev;
+
+  uint64_t primary_key() const { return id; }
+  uint64_t by_rev() const { return rev; }
+  uint128_t by_key() const { return (uint128_t(table.value) << 64) | key; }
+};
+
+typedef eosio::multi_index<"erased"_n, erased_row,
+  indexed_by<"byrev"_n, const_mem_fun<erased_row, uint64_t, &erased_row::by_rev>>,
+  indexed_by<"bykey"_n, const_mem_fun<erased_row, uint128_t, &erased_row::by_key>>
+> erased_table;
+
+
+// Records that the row 'key' of 'table' is being erased, under a new revision.
+inline void record_erase(name self, name table, uint64_t key) {
+  erased_table erased(self, self.value);
+  auto by_key = erased.get_index<"bykey"_n>();
+  auto erased_itr = by_key.find((uint128_t(table.value) << 64) | key);
+
+  if (erased_itr != by_key.end()) {
+    by_key.modify(erased_itr, self, [&](auto& row) {
+      row.rev = next_revision(self);
+    });
+  } else {
+    erased.emplace(self, [&](auto& row) {
+      row.id = erased.available_primary_key();
+      row.table = table;
+      row.key = key;
+      row.rev = next_revision(self);
+    });
+  }
+}
+
+
+// Appends up to 'limit' rows of a 'byrev' index with a revision above 'since_rev'.
+template <typename Index>
+void collect_changes(const Index& by_rev, name table, uint64_t since_rev, uint32_t limit, std::vector<row_change>& changes) {
+  for (auto itr = by_rev.lower_bound(since_rev + 1); itr != by_rev.end() && limit > 0; ++itr, --limit) {
+    changes.push_back({table, itr->primary_key(), itr->rev, false});
+  }
+}
+
+
+// Appends up to 'limit' erased rows with a revision above 'since_rev'.
+inline void collect_erased(name self, uint64_t since_rev, uint32_t limit, std::vector<row_change>& changes) {
+  erased_table erased(self, self.value);
+  auto by_rev = erased.get_index<"byrev"_n>();
+  for (auto itr = by_rev.lower_bound(since_rev + 1); itr != by_rev.end() && limit > 0; ++itr, --limit) {
+    changes.push_back({itr->table, itr->key, itr->rev, true});
+  }
+}
+
+
+// Orders changes collected from several tables by revision and keeps the first 'limit'.
+inline void sort_changes(std::vector<row_change>& changes, uint32_t limit) {
+  std::sort(changes.begin(), changes.end(), [](const row_change& a, const row_change& b) {
+    return a.rev < b.rev;
+  });
+  if (changes.size() > limit) {
+    changes.resize(limit);
+  }
+}
+
+
+// A page of rows packed by the 'exportrows' action, in the format 'importrows' loads.
+// 'next_key' is the lower key of the following page when 'more' is set.
+struct snapshot_page {
+  std::vector<char> rows;
+  uint64_t next_key;
+  bool more;
+};
+
+
+// Packs up to 'limit' rows of 'table' starting at primary key 'lower_key'.
+template <typename Table>
+snapshot_page export_rows(const Table& table, uint64_t lower_key, uint32_t limit) {
+  std::vector<std::decay_t<decltype(*table.begin())>> rows;
+
+  auto itr = table.lower_bound(lower_key);
+  for (; itr != table.end() && rows.size() < limit; ++itr) {
+    rows.push_back(*itr);
+  }
+
+  snapshot_page page;
+  page.rows = eosio::pack(rows);
+  page.more = itr != table.end();
+  page.next_key = page.more ? itr->primary_key() : 0;
+  return page;
+}
+
+
+// Stores the rows of a page packed by export_rows. 'adjust' can change each row before it is stored.
+template <typename Table, typename Fn>
+void import_rows(Table& table, name payer, const std::vector<char>& rows, Fn&& adjust) {
+  for (const auto& imported : eosio::unpack<std::vector<std::decay_t<decltype(*table.begin())>>>(rows)) {
+    table.emplace(payer, [&](auto& row) {
+      row = imported;
+      adjust(row);
+    });
+  }
+}
+
+
+// State transitions reported by the 'receipt' action.
+enum receipt_status : uint8_t {
+  created = 0,
+  deleted = 1,
+  joined = 2,
+  claimed = 3,
+  retired = 4,
+  deposited = 5
+};
+
+
+// Sends the no-op 'receipt' action of the contract to itself so indexers can follow
+// every transition from action traces. The payload has a fixed size of 45 bytes.
+  //campaign - Campaign of the transition
+  //account - User or filler involved, the contract itself for admin transitions
+  //quantity - Tokens moved, empty when only an NFT moves
+  //id - NFT moved, 0 when only tokens move
+  //status - One of receipt_status
+inline void send_receipt(name self, name campaign, name account, const asset& quantity, uint64_t id, uint8_t status) {
+  uint32_t timestamp = now_sec();
+  action(
+    permission_level{self, "active"_n},
+    self,
+    "receipt"_n,
+    std::make_tuple(campaign, account, quantity, id, status, timestamp)
+  ).send();
+}
+
+
+// Parses a decimal number of 1 to 20 digits that fits in 64 bits. Returns false for
+// anything else, so memos that are not campaign ids are rejected before any table read.
+inline bool parse_number(const char* begin, const char* end, uint64_t& value) {
+  if (begin == end || end - begin > 20) {
+    return false;
+  }
+
+  value = 0;
+  for (const char* c = begin; c != end; ++c) {
+    if (*c < '0' || *c > '9') {
+      return false;
+    }
+    uint64_t digit = *c - '0';
+    if (value > (UINT64_MAX - digit) / 10) {
+      return false;
+    }
+    value = value * 10 + digit;
+  }
+  return true;
+}
+
+
+inline bool parse_number(const std::string& text, uint64_t& value) {
+  return parse_number(text.data(), text.data() + text.size(), value);
+}
+
+
+// Splits a transfer memo of the form "<memo_expected>" or "<memo_expected>:<tier>".
+// 'tier' is 0 when the memo does not select one. Returns false if the memo has another form.
+inline bool parse_memo(const std::string& memo, uint64_t& memo_value, uint64_t& tier) {
+  const char* begin = memo.data();
+  const char* end = begin + memo.size();
+  const char* separator = std::find(begin, end, ':');
+
+  tier = 0;
+  if (separator != end && !parse_number(separator + 1, end, tier)) {
+    return false;
+  }
+  return parse_number(begin, separator, memo_value);
+}
+
+
+// Maps each memo_expected to its campaign, keyed by the memo itself so transfer
+// notifications resolve their campaign with primary key lookups only.
+struct [[eosio::table]] memo_entry {
+  uint64_t memo;
+  name campaign;
+
+  uint64_t primary_key() const { return memo; }
+};
+
+typedef eosio::multi_index<"memos"_n, memo_entry> memos_table;
+
+
+// Reserves 'memo' for 'campaign'.
+inline void add_memo(name self, uint64_t memo, name campaign) {
+  memos_table memos(self, self.value);
+  check(memos.find(memo) == memos.end(), "Already an entry with the same memo_expected");
+
+  memos.emplace(self, [&](auto& row) {
+    row.memo = memo;
+    row.campaign = campaign;
+  });
+}
+
+
+// Releases 'memo' when its campaign is deleted.
+inline void erase_memo(name self, uint64_t memo) {
+  memos_table memos(self, self.value);
+  auto memo_itr = memos.find(memo);
+  if (memo_itr != memos.end()) {
+    memos.erase(memo_itr);
+  }
+}
+
+
+// Returns the campaign using 'memo', or an empty name if there is none.
+inline name find_memo(name self, uint64_t memo) {
+  memos_table memos(self, self.value);
+  auto memo_itr = memos.find(memo);
+  return memo_itr == memos.end() ? name() : memo_itr->campaign;
+}
+
+
+// Checks a Merkle proof for 'leaf'. Pairs are hashed in sorted order, so the
+// proof does not need to carry left/right flags.
+inline bool merkle_verify(checksum256 leaf, const std::vector<checksum256>& proof, const checksum256& root) {
+  for (const auto& sibling : proof) {
+    auto a = leaf.extract_as_byte_array();
+    auto b = sibling.extract_as_byte_array();
+    if (b < a) {
+      std::swap(a, b);
+    }
+
+    char buffer[64];
+    std::memcpy(buffer, a.data(), 32);
+    std::memcpy(buffer + 32, b.data(), 32);
+    leaf = sha256(buffer, sizeof(buffer));
+  }
+  return leaf == root;
+}
+
+
+// Accounts allowed to join a campaign, as the Merkle root of the leaves sha256(pack(account)).
+// Campaigns without a row are open to everyone.
+struct [[eosio::table]] allowlist_row {
+  name campaign;
+  checksum256 root;
+
+  uint64_t primary_key() const { return campaign.value; }
+};
+
+typedef eosio::multi_index<"allowlists"_n, allowlist_row> allowlists_table;
+
+
+// Accounts that proved they are in the allowlist of a campaign and have not joined yet.
+// Scoped by campaign, paid by the account.
+struct [[eosio::table]] pass_row {
+  name account;
+
+  uint64_t primary_key() const { return account.value; }
+};
+
+typedef eosio::multi_index<"passes"_n, pass_row> passes_table;
+
+
+// Sets the allowlist root of 'campaign'. An empty root removes the allowlist.
+inline void set_allowlist(name self, name campaign, const checksum256& root) {
+  allowlists_table allowlists(self, self.value);
+  auto allowlist_itr = allowlists.find(campaign.value);
+
+  if (root == checksum256()) {
+    if (allowlist_itr != allowlists.end()) {
+      allowlists.erase(allowlist_itr);
+    }
+  } else if (allowlist_itr == allowlists.end()) {
+    allowlists.emplace(self, [&](auto& row) {
+      row.campaign = campaign;
+      row.root = root;
+    });
+  } else {
+    allowlists.modify(allowlist_itr, self, [&](auto& row) {
+      row.root = root;
+    });
+  }
+}
+
+
+// Checks the allowlist proof of 'account' and stores its pass for the join.
+inline void add_pass(name self, name campaign, name account, const std::vector<checksum256>& proof) {
+  allowlists_table allowlists(self, self.value);
+  auto allowlist_itr = allowlists.find(campaign.value);
+  check(allowlist_itr != allowlists.end(), "This campaign has no allowlist");
+
+  std::vector<char> leaf_data = pack(account);
+  checksum256 leaf = sha256(leaf_data.data(), leaf_data.size());
+  check(merkle_verify(leaf, proof, allowlist_itr->root), "The account is not in the allowlist");
+
+  passes_table passes(self, campaign.value);
+  if (passes.find(account.value) == passes.end()) {
+    passes.emplace(account, [&](auto& row) {
+      row.account = account;
+    });
+  }
+}
+
+
+// Checks on join that 'account' may take part in 'campaign', consuming its pass.
+inline void check_eligible(name self, name campaign, name account) {
+  allowlists_table allowlists(self, self.value);
+  if (allowlists.find(campaign.value) == allowlists.end()) {
+    return;
+  }
+
+  passes_table passes(self, campaign.value);
+  auto pass_itr = passes.find(account.value);
+  check(pass_itr != passes.end(), "This campaign has an allowlist, call 'prove' before the transfer");
+  passes.erase(pass_itr);
+}
+
+
+// Accounts and staked NFTs of 'userram' positions whose staker row was erased to give its
+// RAM back. The row was the only record of the participation, this one outlives it.
+// Scoped by "accounts"_n (keyed by account) or "nfts"_n (keyed by NFT id), paid by the user.
+struct [[eosio::table]] closed_row {
+  uint64_t key;
+
+  uint64_t primary_key() const { return key; }
+};
+
+typedef eosio::multi_index<"closed"_n, closed_row> closed_table;
+
+
+// Records that the position of 'key' in 'scope' ended and its staker row is about to be erased.
+inline void mark_closed(name self, name payer, name scope, uint64_t key) {
+  closed_table closed(self, scope.value);
+  if (closed.find(key) == closed.end()) {
+    closed.emplace(payer, [&](auto& row) {
+      row.key = key;
+    });
+  }
+}
+
+
+// Rejects a join of an account or NFT that already had a position closed by mark_closed.
+inline void check_not_closed(name self, name scope, uint64_t key, const char* message) {
+  closed_table closed(self, scope.value);
+  check(closed.find(key) == closed.end(), message);
+}
+
+
+// Validates the schedule of a new campaign.
+  //start - UNIX time to start the campaign
+  //finish - UNIX time to end the campaign
+  //timetoreward - UNIX time needed to claim rewards
+inline void check_schedule(uint64_t start, uint64_t finish, uint64_t timetoreward) {
+  check(start >= now_sec(), "Date specified in 'start' has already passed and is invalid.");
+  check(start < finish, "Start time must be before the end time.");
+  check(timetoreward < (finish - start), "Duration is greater to active time");
+}
+
+
+// Validates that a campaign accepts new stakers right now.
+inline void check_active(uint64_t start, uint64_t finish) {
+  uint64_t current_time_sec = now_sec();
+  check(current_time_sec >= start, "Campaign has not yet started");
+  check(current_time_sec <= finish, "This campaign has already ended");
+}
+
+
+// Number of complete epochs of 'length' seconds between 'start' and 't',
+// never counting past 'finish'.
+inline uint64_t epoch_at(uint64_t start, uint64_t finish, uint64_t length, uint64_t t) {
+  if (t > finish) {
+    t = finish;
+  }
+  return t > start ? (t - start) / length : 0;
+}
+
+
+// Kind of asset moved by a campaign, either as stake or as reward.
+enum kind : uint8_t {
+  token = 0,
+  nft = 1
+};
+
+
+// A campaign side paid in fungible tokens: 'quantity' is used, 'id' is ignored.
+struct token_kind {
+  static constexpr uint8_t value = kind::token;
+
+  static void send(name self, name account, name to, const asset& quantity, uint64_t id, const std::string& memo) {
+    send_tokens(self, account, to, quantity, memo);
+  }
+};
+
+
+// A campaign side paid in a single simpleassets NFT: 'id' is used, 'quantity' is ignored.
+struct nft_kind {
+  static constexpr uint8_t value = kind::nft;
+
+  static void send(name self, name account, name to, const asset& quantity, uint64_t id, const std::string& memo) {
+    send_nft(self, account, to, id, memo);
+  }
+};
+
+
+// Lifecycle of a position, parameterized by what is staked and what is rewarded.
+template <typename StakeKind, typename RewardKind>
+struct engine {
+  // Gives the staked tokens or NFT back to the participant.
+  static void refund(name self, name stake_account, name to, const asset& entry, uint64_t id_staked, const std::string& memo) {
+    StakeKind::send(self, stake_account, to, entry, id_staked, memo);
+  }
+
+  // Pays the campaign reward to the participant.
+  static void payout(name self, name reward_account, name to, const asset& reward, uint64_t id_reward, const std::string& memo) {
+    RewardKind::send(self, reward_account, to, reward, id_reward, memo);
+  }
+
+  // Settles a matured position: reward first, then the stake if it is returned.
+  static void settle(name self, name stake_account, name reward_account, name to,
+                     const asset& entry, uint64_t id_staked, bool return_entry,
+                     const asset& reward, uint64_t id_reward) {
+    payout(self, reward_account, to, reward, id_reward, "Reward claimed");
+    if (return_entry) {
+      refund(self, stake_account, to, entry, id_staked, "Returned entry");
+    }
+  }
+};
+
+
+// Checks shared by claimreward in every contract.
+inline void check_claimable(bool claimed, bool retired, uint64_t claimable_reward) {
+  check(!claimed && !retired, "Already claimed or withdrawn from this campaign");
+  check(now_sec() >= claimable_reward, "You have not completed stake time yet!");
+}
+
+
+// Checks shared by retirestake in every contract.
+inline void check_retirable(bool claimed, bool retired, uint64_t claimable_reward) {
+  check(!claimed && !retired, "Already claimed or withdrawn from this campaign");
+  check(now_sec() < claimable_reward, "Stake completed, you must claim your reward");
+}
+
+
+
+// Tables of the combined n1staking contract.
+
+struct [[eosio::table]] campaign_row {
+  name campaign;
+  name filler;
+  uint8_t stakekind;
+  uint8_t rewardkind;
+  uint64_t start;
+  uint64_t finish;
+  uint64_t timetoreward;
+  name stakeaccount;
+  name rewardaccount;
+  asset entry;
+  asset reward;
+  bool return_entry;
+  name author;
+  name category;
+  checksum256 idata_hash;
+  uint64_t places;
+  uint64_t joined;
+  uint64_t available_rewards;
+  uint64_t memo_expected;
+  bool autorenew;
+  bool deferred;
+
+  uint64_t primary_key() const { return campaign.value; }
+};
+
+
+struct [[eosio::table]] staker_row {
+  name participant;
+  name campaign;
+  uint64_t join_time;
+  uint64_t claimable_reward;
+  bool claimed;
+  bool retired;
+  uint64_t id_staked;
+  uint64_t id_reward;
+  uint64_t tier;
+  uint64_t epoch;
+
+  uint64_t primary_key() const { return participant.value; }
+  uint64_t by_campaign() const { return campaign.value; }
+  uint64_t by_staked() const { return id_staked; }
+  uint128_t by_maturity() const { return maturity_key(campaign, claimable_reward); }
+
+  // Orders the positions of each campaign by the time they can be claimed.
+  static uint128_t maturity_key(name campaign, uint64_t claimable_reward) {
+    return (uint128_t(campaign.value) << 64) | claimable_reward;
+  }
+};
+
+
+// Progress of 'settle' through a deferred campaign: the last position visited,
+// in claimable_reward order (ties in participant order).
+struct [[eosio::table]] cursor_row {
+  name campaign;
+  uint64_t claimable_reward;
+  name participant;
+  uint64_t settled;
+
+  uint64_t primary_key() const { return campaign.value; }
+};
+
+
+// Optional lock tiers of a campaign, scoped by campaign name.
+// Tier 0 is the campaign itself and is never stored.
+struct [[eosio::table]] tier_row {
+  uint64_t tier;
+  uint64_t timetoreward;
+  asset reward;
+  uint64_t places;
+  uint64_t joined;
+
+  uint64_t primary_key() const { return tier; }
+};
+
+
+struct [[eosio::table]] reward_row {
+  uint64_t id;
+  name campaign;
+  bool available;
+  bool delivered;
+
+  uint64_t primary_key() const { return id; }
+  uint64_t by_campaign() const { return campaign.value; }
+};
+
+
+typedef eosio::multi_index<"campaigns"_n, campaign_row> campaigns_table;
+
+typedef eosio::multi_index<"stakers"_n, staker_row,
+  indexed_by<"bycampaign"_n, const_mem_fun<staker_row, uint64_t, &staker_row::by_campaign>>,
+  indexed_by<"bystaked"_n, const_mem_fun<staker_row, uint64_t, &staker_row::by_staked>>,
+  indexed_by<"bymaturity"_n, const_mem_fun<staker_row, uint128_t, &staker_row::by_maturity>>
+> stakers_table;
+
+typedef eosio::multi_index<"cursors"_n, cursor_row> cursors_table;
+
+typedef eosio::multi_index<"tiers"_n, tier_row> tiers_table;
+
+typedef eosio::multi_index<"rewards"_n, reward_row,
+  indexed_by<"bycampaign"_n, const_mem_fun<reward_row, uint64_t, &reward_row::by_campaign>>
+> rewards_table;
+
+
+// simpleassets NFT table, read to validate staked NFTs.
+struct sassets {
+  uint64_t id;
+  name owner;
+  name author;
+  name category;
+  std::string idata;
+
+  uint64_t primary_key() const { return id; }
+};
+
+typedef eosio::multi_index<"sassets"_n, sassets> sassets_table;
+
+} // namespace n1engine
@@ -4,8 +4,12 @@
 #include <eosio/string.hpp>
 #include <eosio/system.hpp>
 
+#include "n1staking.hpp"
+
 using namespace eosio;
 
+typedef n1engine::engine<n1engine::token_kind, n1engine::nft_kind> tokentonft_engine;
+
 
 class [[eosio::contract("n1tokentonft")]] n1tokentonft : public contract {
 public:
@@ -33,54 +37,106 @@ public:
                   bool printondemand, uint64_t memo_expected)  {
     require_auth(get_self());
 
+    create_campaign(campaign, filler, start, finish, timetoreward, nftaccount, tokenaccount,
+                    entry, return_entry, places, islimited, printondemand, memo_expected);
+  }
+
+
+  // Parameters of one campaign in setcampaigns, same meaning as in newcampign
+  struct campaign_config {
+    name campaign;
+    name filler;
+    uint64_t start;
+    uint64_t finish;
+    uint64_t timetoreward;
+    name nftaccount;
+    name tokenaccount;
+    asset entry;
+    bool return_entry;
+    uint64_t places;
+    bool islimited;
+    bool printondemand;
+    uint64_t memo_expected;
+  };
+
+
+  // Set up several stake campaigns in one transaction
+    //campaigns - One entry per campaign, validated like newcampign
+  [[eosio::action]]
+  void setcampaigns(std::vector<campaign_config> campaigns) {
+    require_auth(get_self());
+
+    if (campaigns.empty()) {
+      check(false, "No campaigns to set up");
+    }
+
+    for (const auto& config : campaigns) {
+      create_campaign(config.campaign, config.filler, config.start, config.finish, config.timetoreward,
+                      config.nftaccount, config.tokenaccount, config.entry, config.return_entry, config.places,
+                      config.islimited, config.printondemand, config.memo_expected);
+    }
+  }
+
+
+  // Update the mutable parameters of a campaign without recreating it
+    //campaign - The campaign to update
+    //finish - New UNIX time to end the campaign
+    //places - New maximum number of rewards, not lower than the rewards already added
+  [[eosio::action]]
+  void updcampaign(name campaign, uint64_t finish, uint64_t places) {
+    require_auth(get_self());
+
     datacampaign_table datacampaign(get_self(), get_self().value);
     auto existing = datacampaign.find(campaign.value);
-    check(existing == datacampaign.end(), "Campaign already exists");
-
-    check(memo_expected > 0, "memo_expected must be a valid number");
 
-    auto existing_memo = datacampaign.get_index<"bymemo"_n>();
-    auto itr = existing_memo.find(memo_expected);
-    check(itr == existing_memo.end(), "Already an entry with the same memo_expected");
+    if (existing == datacampaign.end()) {
+      check(false, "The campaign does not exist ");
+    }
 
     time_point_sec current_time = current_time_point();
-    uint64_t current_time_sec = current_time.sec_since_epoch();
-
-    if (start < current_time.sec_since_epoch()) {
-      check(false, "Date specified in 'start' has already passed and is invalid.");
+    if (finish <= current_time.sec_since_epoch()) {
+      check(false, "Date specified in 'finish' has already passed and is invalid.");
     }
 
-    if (start >= finish) {
+    if (finish <= existing->start) {
       check(false, "Start time must be before the end time.");
     }
 
-    if (timetoreward >= (finish - start)) {
+    if (existing->timetoreward >= (finish - existing->start)) {
       check(false, "Duration is greater to active time");
     }
 
-    if (!((islimited && !printondemand) || (!islimited && printondemand))) {
-      check(false, "Select exactly one, 'islimited' or 'printondemand'.");
+    if (existing->printondemand && places != 0) {
+      check(false, "Places must be 0 (unlimited) when 'printondemand' is active");
     }
 
-    
-    if (printondemand && places != 0) {
-      eosio::check(false, "Places must be 0 (unlimited) when 'printondemand' is active");
+    if (existing->islimited) {
+      rewards_table rewards(get_self(), get_self().value);
+      auto campaign_entries = rewards.get_index<"bycampaign"_n>();
+      auto campaign_entries_itr = campaign_entries.lower_bound(campaign.value);
+      auto campaign_entries_end = campaign_entries.upper_bound(campaign.value);
+
+      uint64_t campaign_entry_count = 0;
+      for (auto it = campaign_entries_itr; it != campaign_entries_end; ++it) {
+        campaign_entry_count++;
+      }
+
+      if (places < campaign_entry_count) {
+        check(false, "Places cannot be lower than the rewards already added");
+      }
     }
-    
-    datacampaign.emplace(get_self(), [&](auto& row) {
-      row.campaign = campaign;
-      row.filler = filler;
-      row.start = start;
+
+    datacampaign.modify(existing, get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
       row.finish = finish;
-      row.timetoreward = timetoreward;
-      row.nftaccount = nftaccount;
-      row.tokenaccount = tokenaccount;
-      row.entry = entry;
-      row.return_entry = return_entry;
       row.places = places;
-      row.islimited = islimited;
-      row.printondemand = printondemand;
-      row.memo_expected = memo_expected;
+    });
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto campaign_entry = campaignhot.find(campaign.value);
+    campaignhot.modify(campaign_entry, get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.finish = finish;
     });
   }
 
@@ -95,25 +151,584 @@ public:
     auto existing = datacampaign.find(campaign.value);
 
     if (existing != datacampaign.end()) {
+      n1engine::erase_memo(get_self(), existing->memo_expected);
+      n1engine::set_allowlist(get_self(), campaign, checksum256());
+      n1engine::record_erase(get_self(), "datacampaign"_n, campaign.value);
       datacampaign.erase(existing);
+
+      campaignhot_table campaignhot(get_self(), get_self().value);
+      auto campaign_entry = campaignhot.find(campaign.value);
+      if (campaign_entry != campaignhot.end()) {
+        n1engine::record_erase(get_self(), "campaignhot"_n, campaign.value);
+        campaignhot.erase(campaign_entry);
+      }
+
+      stakelevels_table stakelevels(get_self(), campaign.value);
+      auto level_entry = stakelevels.begin();
+      while (level_entry != stakelevels.end()) {
+        level_entry = stakelevels.erase(level_entry);
+      }
+
+      n1engine::send_receipt(get_self(), campaign, get_self(), asset(), 0, n1engine::receipt_status::deleted);
     } else {
       check(false, "The campaign does not exist ");
     }
   }
 
 
+  // No-op notification sent by the contract on every campaign transition. See n1engine::send_receipt.
+  [[eosio::action]]
+  void receipt(name campaign, name account, asset quantity, uint64_t id, uint8_t status, uint32_t timestamp) {
+    require_auth(get_self());
+  }
+
+
+  // Sets how long retired tokens wait in the releases queue before being returned.
+  // Only before the campaign starts.
+    //campaign - The campaign to configure
+    //cooldown - Seconds to wait, 0 returns the tokens on retirestake
+  [[eosio::action]]
+  void setcooldown(name campaign, uint64_t cooldown) {
+    require_auth(get_self());
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto existing = campaignhot.find(campaign.value);
+
+    if (existing == campaignhot.end()) {
+      check(false, "The campaign does not exist ");
+    }
+
+    time_point_sec current_time = current_time_point();
+    if (current_time.sec_since_epoch() >= existing->start) {
+      check(false, "The campaign has already started");
+    }
+
+    campaignhot.modify(existing, get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.cooldown = cooldown;
+    });
+  }
+
+
+  // Makes participants pay the RAM of their own staker row. Only before the campaign starts.
+    //campaign - Campaign to configure
+    //userram - true if each participant opens and pays for their position
+  [[eosio::action]]
+  void setuserram(name campaign, bool userram) {
+    require_auth(get_self());
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto existing = campaignhot.find(campaign.value);
+
+    if (existing == campaignhot.end()) {
+      check(false, "The campaign does not exist ");
+    }
+
+    time_point_sec current_time = current_time_point();
+    check(current_time.sec_since_epoch() < existing->start, "The campaign has already started");
+
+    campaignhot.modify(existing, get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.userram = userram;
+    });
+  }
+
+
+  // Creates the staker row of 'user', paid by 'user', for a 'userram' campaign.
+  // Sent in the same transaction before the token transfer, which fills the row.
+    //user - Future participant, pays the RAM of the row
+    //campaign - Campaign to join
+  [[eosio::action]]
+  void open(name user, name campaign) {
+    require_auth(user);
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto existing = campaignhot.find(campaign.value);
+
+    if (existing == campaignhot.end()) {
+      check(false, "The campaign does not exist ");
+    }
+    check(existing->userram, "The contract pays the RAM of this campaign");
+
+    stakers_table stakers(get_self(), get_self().value);
+    check(stakers.find(user.value) == stakers.end(), "You are already participating or have participated.");
+    n1engine::check_not_closed(get_self(), "accounts"_n, user.value, "You are already participating or have participated.");
+
+    stakers.emplace(user, [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.participant = user;
+      row.campaign = campaign;
+      row.join_time = 0;
+      row.claimable_reward = 0;
+      row.claimed = false;
+      row.retired = false;
+      row.id_asigned = 0;
+      row.staked = asset(0, existing->entry.symbol);
+      row.level = 0;
+    });
+  }
+
+
+  // Restricts a campaign to the accounts of a Merkle tree
+    //campaign - Campaign to restrict
+    //root - Merkle root of the leaves sha256(pack(account)), empty to open the campaign to everyone
+  [[eosio::action]]
+  void setallowlist(name campaign, checksum256 root) {
+    require_auth(get_self());
+
+    datacampaign_table datacampaign(get_self(), get_self().value);
+    if (datacampaign.find(campaign.value) == datacampaign.end()) {
+      check(false, "The campaign does not exist ");
+    }
+
+    n1engine::set_allowlist(get_self(), campaign, root);
+  }
+
+
+  // Proves that 'user' is in the allowlist of a campaign. Sent in the same transaction before the token transfer.
+    //user - Account joining the campaign
+    //campaign - Campaign with an allowlist
+    //proof - Merkle proof of the leaf sha256(pack(user))
+  [[eosio::action]]
+  void prove(name user, name campaign, std::vector<checksum256> proof) {
+    require_auth(user);
+    n1engine::add_pass(get_self(), campaign, user, proof);
+  }
+
+
+  // Deletes a row created by 'open' that was never filled, giving its RAM back.
+    //user - Owner of the row
+  [[eosio::action]]
+  void close(name user) {
+    require_auth(user);
+
+    stakers_table stakers(get_self(), get_self().value);
+    auto staker_entry = stakers.find(user.value);
+
+    if (staker_entry == stakers.end()) {
+      check(false, "You are not participating in any campaign");
+    }
+    check(staker_entry->join_time == 0, "The position is already in use");
+
+    n1engine::record_erase(get_self(), "stakers"_n, user.value);
+    stakers.erase(staker_entry);
+  }
+
+
+  // Returns the due entries of the releases queue, oldest first. Anyone can call it.
+  // Entries of the same account, contract and symbol are paid in a single transfer.
+    //max_rows - Maximum number of queue entries processed
+  [[eosio::action]]
+  void release(uint64_t max_rows) {
+    time_point_sec current_time = current_time_point();
+    uint64_t current_time_sec = current_time.sec_since_epoch();
+
+    releases_table releases(get_self(), get_self().value);
+    auto by_due = releases.get_index<"bydue"_n>();
+    auto release_entry = by_due.begin();
+
+    std::vector<std::pair<name, extended_asset>> transfers;
+    uint64_t processed = 0;
+
+    while (release_entry != by_due.end() && release_entry->due <= current_time_sec && processed < max_rows) {
+      bool merged = false;
+      for (auto& transfer : transfers) {
+        if (transfer.first == release_entry->account &&
+            transfer.second.contract == release_entry->tokenaccount &&
+            transfer.second.quantity.symbol == release_entry->quantity.symbol) {
+          transfer.second.quantity += release_entry->quantity;
+          merged = true;
+          break;
+        }
+      }
+      if (!merged) {
+        transfers.push_back({release_entry->account, extended_asset(release_entry->quantity, release_entry->tokenaccount)});
+      }
+
+      release_entry = by_due.erase(release_entry);
+      processed++;
+    }
+
+    if (processed == 0) {
+      eosio::check(false, "No releases are due");
+    }
+
+    for (const auto& transfer : transfers) {
+      n1engine::send_tokens(get_self(), transfer.second.contract, transfer.first, transfer.second.quantity, "Returned entry");
+    }
+  }
+
+
+  // Chooses the NFT reward when the user claims instead of when they join, so joining
+  // only reserves one of the available rewards. Only before the campaign starts.
+    //campaign - The campaign to configure
+    //lazyassign - true to choose the reward at claim time
+  [[eosio::action]]
+  void setlazy(name campaign, bool lazyassign) {
+    require_auth(get_self());
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto existing = campaignhot.find(campaign.value);
+
+    if (existing == campaignhot.end()) {
+      check(false, "The campaign does not exist ");
+    }
+
+    time_point_sec current_time = current_time_point();
+    if (current_time.sec_since_epoch() >= existing->start) {
+      check(false, "The campaign has already started");
+    }
+
+    if (lazyassign && existing->printondemand) {
+      check(false, "'lazyassign' is only valid for 'islimited' campaigns");
+    }
+
+    // Rewards added before the switch were not counted in 'available_rewards'.
+    // Rewards of stake levels are counted by their level.
+    rewards_table rewards(get_self(), get_self().value);
+    auto by_level = rewards.get_index<"bylevel"_n>();
+    uint64_t available = 0;
+    for (auto reward_itr = by_level.lower_bound(rewards::level_key(campaign, 0));
+         reward_itr != by_level.end() && reward_itr->by_level() == rewards::level_key(campaign, 0); ++reward_itr) {
+      available++;
+    }
+
+    campaignhot.modify(existing, get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.lazyassign = lazyassign;
+      row.available_rewards = lazyassign ? available : 0;
+    });
+  }
+
+
+  // Turns 'entry' into a minimum: users may stake any amount above it and the
+  // campaign keeps the total staked. Only before the campaign starts.
+    //campaign - The campaign to make weighted
+  [[eosio::action]]
+  void setweighted(name campaign) {
+    require_auth(get_self());
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto existing = campaignhot.find(campaign.value);
+
+    if (existing == campaignhot.end()) {
+      check(false, "The campaign does not exist ");
+    }
+
+    time_point_sec current_time = current_time_point();
+    if (current_time.sec_since_epoch() >= existing->start) {
+      check(false, "The campaign has already started");
+    }
+
+    campaignhot.modify(existing, get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.weighted = true;
+      row.total_staked = asset(0, row.entry.symbol);
+    });
+  }
+
+
+  // Adds or changes a stake level of a weighted campaign. Stakes of at least 'min_stake'
+  // receive one of the rewards deposited with the memo "<memo_expected>:<level>".
+  // Only before the campaign starts.
+    //campaign - The weighted campaign
+    //level - Number of the level, above 0
+    //min_stake - Minimum stake of the level, above the campaign's entry
+  [[eosio::action]]
+  void setstakelvl(name campaign, uint64_t level, asset min_stake) {
+    require_auth(get_self());
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    auto existing = campaignhot.find(campaign.value);
+
+    if (existing == campaignhot.end()) {
+      check(false, "The campaign does not exist ");
+    }
+
+    time_point_sec current_time = current_time_point();
+    if (current_time.sec_since_epoch() >= existing->start) {
+      check(false, "The campaign has already started");
+    }
+
+    if (!existing->weighted) {
+      check(false, "Stake levels are only valid for weighted campaigns");
+    }
+
+    check(level > 0, "Level 0 is the campaign's own entry");
+    check(min_stake.symbol == existing->entry.symbol && min_stake > existing->entry,
+          "'min_stake' must be above the campaign's entry");
+
+    stakelevels_table stakelevels(get_self(), campaign.value);
+    auto level_entry = stakelevels.find(level);
+
+    if (level_entry == stakelevels.end()) {
+      stakelevels.emplace(get_self(), [&](auto& row) {
+        row.level = level;
+        row.min_stake = min_stake;
+        row.available = 0;
+      });
+    } else {
+      stakelevels.modify(level_entry, get_self(), [&](auto& row) {
+        row.min_stake = min_stake;
+      });
+    }
+  }
+
+
+  struct stake_position {
+    name participant;
+    asset staked;
+  };
+
+  // Returns the active stakers of a campaign with the largest stakes, largest first.
+    //campaign - The campaign to read
+    //limit - Maximum number of stakers returned
+  [[eosio::action, eosio::read_only]]
+  std::vector<stake_position> topstakers(name campaign, uint32_t limit) {
+    std::vector<stake_position> result;
+
+    stakers_table stakers(get_self(), get_self().value);
+    auto by_stake = stakers.get_index<"bystake"_n>();
+    auto staker_entry = by_stake.upper_bound(stakers::stake_key(campaign, UINT64_MAX));
+
+    while (staker_entry != by_stake.begin() && result.size() < limit) {
+      staker_entry--;
+      // Closed positions have a zero stake key and sort after every active one.
+      if (staker_entry->campaign != campaign || staker_entry->by_stake() == stakers::stake_key(campaign, 0)) {
+        break;
+      }
+      result.push_back({staker_entry->participant, staker_entry->staked});
+    }
+    return result;
+  }
+
+
+  // Rewrites the datacampaign, stakers and rewards rows stored by the previous version of
+  // the contract with the current layout and indexes, builds the campaignhot row of each old
+  // campaign and registers its memo in the memos table. Call it until the migration is complete.
+    //max_rows - Maximum number of rows visited in this call
+  [[eosio::action]]
+  void migrate(uint64_t max_rows) {
+    require_auth(get_self());
+
+    n1engine::migration_singleton migration(get_self(), get_self().value);
+    n1engine::migration_state state = migration.get_or_default();
+    check(state.table < 3, "The migration is complete");
+
+    datacampaign_table datacampaign(get_self(), get_self().value);
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    uint64_t budget = max_rows;
+
+    while (state.table < 3 && budget > 0) {
+      bool done = false;
+
+      if (state.table == 0) {
+        legacy_datacampaign_table legacy(get_self(), get_self().value);
+        done = n1engine::migrate_rows(legacy, state.next_key, budget, [&](const auto& old) {
+          datacampaign.emplace(get_self(), [&](auto& row) {
+            row.rev = n1engine::next_revision(get_self());
+            row.campaign = old.campaign;
+            row.filler = old.filler;
+            row.start = old.start;
+            row.finish = old.finish;
+            row.timetoreward = old.timetoreward;
+            row.nftaccount = old.nftaccount;
+            row.tokenaccount = old.tokenaccount;
+            row.entry = old.entry;
+            row.return_entry = old.return_entry;
+            row.places = old.places;
+            row.islimited = old.islimited;
+            row.printondemand = old.printondemand;
+            row.memo_expected = old.memo_expected;
+          });
+
+          campaignhot.emplace(get_self(), [&](auto& row) {
+            row.rev = n1engine::next_revision(get_self());
+            row.campaign = old.campaign;
+            row.start = old.start;
+            row.finish = old.finish;
+            row.timetoreward = old.timetoreward;
+            row.nftaccount = old.nftaccount;
+            row.tokenaccount = old.tokenaccount;
+            row.entry = old.entry;
+            row.return_entry = old.return_entry;
+            row.printondemand = old.printondemand;
+            row.lazyassign = false;
+            row.available_rewards = 0;
+            row.weighted = false;
+            row.total_staked = asset(0, old.entry.symbol);
+            row.cooldown = 0;
+            row.userram = false;
+          });
+
+          n1engine::add_memo(get_self(), old.memo_expected, old.campaign);
+        });
+      } else if (state.table == 1) {
+        legacy_stakers_table legacy(get_self(), get_self().value);
+        stakers_table stakers(get_self(), get_self().value);
+        done = n1engine::migrate_rows(legacy, state.next_key, budget, [&](const auto& old) {
+          auto campaign_entry = datacampaign.find(old.campaign.value);
+
+          stakers.emplace(get_self(), [&](auto& row) {
+            row.rev = n1engine::next_revision(get_self());
+            row.participant = old.participant;
+            row.campaign = old.campaign;
+            row.join_time = old.join_time;
+            row.claimable_reward = old.claimable_reward;
+            row.claimed = old.claimed;
+            row.retired = old.retired;
+            row.id_asigned = old.id_asigned;
+            row.staked = campaign_entry != datacampaign.end() ? campaign_entry->entry : asset();
+            row.level = 0;
+          });
+        });
+      } else {
+        legacy_rewards_table legacy(get_self(), get_self().value);
+        rewards_table rewards(get_self(), get_self().value);
+        done = n1engine::migrate_rows(legacy, state.next_key, budget, [&](const auto& old) {
+          rewards.emplace(get_self(), [&](auto& row) {
+            row.rev = n1engine::next_revision(get_self());
+            row.id = old.id;
+            row.campaign = old.campaign;
+            row.available = old.available;
+            row.delivered = old.delivered;
+            row.level = 0;
+          });
+        });
+      }
+
+      if (done) {
+        state.table++;
+        state.next_key = 0;
+      }
+    }
+
+    migration.set(state, get_self());
+  }
+
+
+  // Lists datacampaign, campaignhot, stakers and rewards rows modified or erased after a revision, oldest first.
+    //since_rev - Last revision already seen by the caller, 0 for everything
+    //limit - Maximum number of rows returned
+  [[eosio::action, eosio::read_only]]
+  std::vector<n1engine::row_change> changes(uint64_t since_rev, uint32_t limit) {
+    std::vector<n1engine::row_change> result;
+
+    datacampaign_table datacampaign(get_self(), get_self().value);
+    n1engine::collect_changes(datacampaign.get_index<"byrev"_n>(), "datacampaign"_n, since_rev, limit, result);
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    n1engine::collect_changes(campaignhot.get_index<"byrev"_n>(), "campaignhot"_n, since_rev, limit, result);
+
+    stakers_table stakers(get_self(), get_self().value);
+    n1engine::collect_changes(stakers.get_index<"byrev"_n>(), "stakers"_n, since_rev, limit, result);
+
+    rewards_table rewards(get_self(), get_self().value);
+    n1engine::collect_changes(rewards.get_index<"byrev"_n>(), "rewards"_n, since_rev, limit, result);
+
+    n1engine::collect_erased(get_self(), since_rev, limit, result);
+
+    n1engine::sort_changes(result, limit);
+    return result;
+  }
+
+
+  // Exports rows of 'datacampaign', 'campaignhot', 'stakelevels', 'allowlists', 'rewards' or
+  // 'stakers' in packed pages for 'importrows'.
+    //table - Table to read
+    //scope - Campaign of the 'stakelevels' rows, ignored by the other tables
+    //lower_key - First primary key of the page, 'next_key' of the previous page
+    //limit - Maximum number of rows in the page
+  [[eosio::action, eosio::read_only]]
+  n1engine::snapshot_page exportrows(name table, name scope, uint64_t lower_key, uint32_t limit) {
+    if (table == "datacampaign"_n) {
+      datacampaign_table datacampaign(get_self(), get_self().value);
+      return n1engine::export_rows(datacampaign, lower_key, limit);
+    }
+    if (table == "campaignhot"_n) {
+      campaignhot_table campaignhot(get_self(), get_self().value);
+      return n1engine::export_rows(campaignhot, lower_key, limit);
+    }
+    if (table == "stakelevels"_n) {
+      stakelevels_table stakelevels(get_self(), scope.value);
+      return n1engine::export_rows(stakelevels, lower_key, limit);
+    }
+    if (table == "allowlists"_n) {
+      n1engine::allowlists_table allowlists(get_self(), get_self().value);
+      return n1engine::export_rows(allowlists, lower_key, limit);
+    }
+    if (table == "rewards"_n) {
+      rewards_table rewards(get_self(), get_self().value);
+      return n1engine::export_rows(rewards, lower_key, limit);
+    }
+
+    check(table == "stakers"_n, "This table cannot be exported");
+    stakers_table stakers(get_self(), get_self().value);
+    return n1engine::export_rows(stakers, lower_key, limit);
+  }
+
+
+#ifdef N1STAKING_IMPORT
+  // Loads a page produced by 'exportrows' to set up test and benchmark environments
+  // without replaying transfers. Only compiled with -DN1STAKING_IMPORT, never in production.
+  // Imported rows get new revisions, so 'changes' on the local node starts from them.
+    //table - Table the rows belong to
+    //scope - Campaign of the 'stakelevels' rows, ignored by the other tables
+    //rows - The 'rows' of a snapshot_page
+  [[eosio::action]]
+  void importrows(name table, name scope, std::vector<char> rows) {
+    require_auth(get_self());
+
+    if (table == "datacampaign"_n) {
+      datacampaign_table datacampaign(get_self(), get_self().value);
+      n1engine::import_rows(datacampaign, get_self(), rows, [&](auto& row) {
+        n1engine::add_memo(get_self(), row.memo_expected, row.campaign);
+        row.rev = n1engine::next_revision(get_self());
+      });
+    } else if (table == "campaignhot"_n) {
+      campaignhot_table campaignhot(get_self(), get_self().value);
+      n1engine::import_rows(campaignhot, get_self(), rows, [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
+      });
+    } else if (table == "stakelevels"_n) {
+      stakelevels_table stakelevels(get_self(), scope.value);
+      n1engine::import_rows(stakelevels, get_self(), rows, [](auto&) {});
+    } else if (table == "allowlists"_n) {
+      for (const auto& allowlist : unpack<std::vector<n1engine::allowlist_row>>(rows)) {
+        n1engine::set_allowlist(get_self(), allowlist.campaign, allowlist.root);
+      }
+    } else if (table == "rewards"_n) {
+      rewards_table rewards(get_self(), get_self().value);
+      n1engine::import_rows(rewards, get_self(), rows, [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
+      });
+    } else {
+      check(table == "stakers"_n, "This table cannot be imported");
+      stakers_table stakers(get_self(), get_self().value);
+      n1engine::import_rows(stakers, get_self(), rows, [&](auto& row) {
+        row.rev = n1engine::next_revision(get_self());
+      });
+    }
+  }
+#endif
+
+
   // The logic of reception of NFTs and add as reward
   [[eosio::on_notify("simpleassets::transfer")]]
   void nft_transfer_in(name from, name to, std::vector<uint64_t>& assetids, std::string memo) {
     if (to == get_self()) {
       
-      uint64_t memo_value = std::stoull(memo);
+      // "<memo_expected>:<level>" deposits a reward for a stake level of a weighted campaign.
+      uint64_t memo_value;
+      uint64_t level;
+      if (!n1engine::parse_memo(memo, memo_value, level)) {
+        eosio::check(false, "Memo must be a campaign number");
+      }
 
       datacampaign_table datacampaign(get_self(), get_self().value); 
-      auto existing_memo = datacampaign.get_index<"bymemo"_n>();
-      auto itr = existing_memo.find(memo_value);
+      auto itr = datacampaign.find(n1engine::find_memo(get_self(), memo_value).value);
 
-      if (itr != existing_memo.end()) {
+      if (itr != datacampaign.end()) {
        
         time_point_sec current_time = current_time_point();
         uint64_t current_time_sec = current_time.sec_since_epoch();
@@ -179,12 +794,36 @@ public:
           
           eosio::check(false, "Limit of rewards for this campaign has been reached.");
         }
+        if (level != 0) {
+          stakelevels_table stakelevels(get_self(), itr->campaign.value);
+          auto level_entry = stakelevels.find(level);
+          if (level_entry == stakelevels.end()) {
+            eosio::check(false, "The stake level does not exist");
+          }
+          stakelevels.modify(level_entry, get_self(), [&](auto& row) {
+            row.available++;
+          });
+        }
+
         rewards.emplace(get_self(), [&](auto& row) {
+          row.rev = n1engine::next_revision(get_self());
           row.id = id_uint64;
           row.campaign = itr->campaign;
           row.available = true;
           row.delivered = false;
+          row.level = level;
         });
+
+        campaignhot_table campaignhot(get_self(), get_self().value);
+        auto campaign_entry = campaignhot.find(itr->campaign.value);
+        if (campaign_entry->lazyassign && level == 0) {
+          campaignhot.modify(campaign_entry, get_self(), [&](auto& row) {
+            row.rev = n1engine::next_revision(get_self());
+            row.available_rewards++;
+          });
+        }
+
+        n1engine::send_receipt(get_self(), itr->campaign, from, asset(), id_uint64, n1engine::receipt_status::deposited);
       } else {
         eosio::check(false, "Memo not matching a campaign");
       }
@@ -205,17 +844,33 @@ public:
     if (existing != rewards.end()) {
         name campaign = existing->campaign;
 
-        datacampaign_table datacampaign(get_self(), get_self().value);
-        auto datacampaign_entry = datacampaign.find(campaign.value);
+        campaignhot_table campaignhot(get_self(), get_self().value);
+        auto campaign_entry = campaignhot.find(campaign.value);
 
-        if (datacampaign_entry == datacampaign.end()) {
+        if (campaign_entry == campaignhot.end()) {
+            n1engine::record_erase(get_self(), "rewards"_n, id);
             rewards.erase(existing);
         } else {
             time_point_sec current_time = current_time_point();
             uint64_t current_time_sec = current_time.sec_since_epoch();
-            if (current_time_sec >= datacampaign_entry->start) {                
+            if (current_time_sec >= campaign_entry->start) {                
                 eosio::check(false, "The campaign has already started, entry cannot be deleted.");
             } else {
+                if (existing->level != 0) {
+                    stakelevels_table stakelevels(get_self(), campaign.value);
+                    auto level_entry = stakelevels.find(existing->level);
+                    if (level_entry != stakelevels.end()) {
+                        stakelevels.modify(level_entry, get_self(), [&](auto& row) {
+                            row.available--;
+                        });
+                    }
+                } else if (campaign_entry->lazyassign && existing->available) {
+                    campaignhot.modify(campaign_entry, get_self(), [&](auto& row) {
+                        row.rev = n1engine::next_revision(get_self());
+                        row.available_rewards--;
+                    });
+                }
+                n1engine::record_erase(get_self(), "rewards"_n, id);
                 rewards.erase(existing);
             }
         }
@@ -243,6 +898,7 @@ public:
 
       while (reward_entry != reward_end) {
           if (reward_entry->campaign == camptoclear) {       
+              n1engine::record_erase(get_self(), "rewards"_n, reward_entry->id);
               reward_entry = rewards.erase(reward_entry);
               foundEntries = true; 
           } else {
@@ -251,6 +907,22 @@ public:
           }
       }
       eosio::check(foundEntries, "No entries were found for specified campaign.");
+
+      campaignhot_table campaignhot(get_self(), get_self().value);
+      auto campaign_entry = campaignhot.find(camptoclear.value);
+      if (campaign_entry != campaignhot.end() && campaign_entry->lazyassign) {
+          campaignhot.modify(campaign_entry, get_self(), [&](auto& row) {
+              row.rev = n1engine::next_revision(get_self());
+              row.available_rewards = 0;
+          });
+      }
+
+      stakelevels_table stakelevels(get_self(), camptoclear.value);
+      for (auto level_entry = stakelevels.begin(); level_entry != stakelevels.end(); ++level_entry) {
+          stakelevels.modify(level_entry, get_self(), [&](auto& row) {
+              row.available = 0;
+          });
+      }
   }
 
 
@@ -258,47 +930,93 @@ public:
   [[eosio::on_notify("niceonetoken::transfer")]]
   void user_join(name from, name to, asset quantity, std::string memo) {
       if (to == get_self()) {
-          uint64_t memo_value = std::stoull(memo);
+          // Transfers whose memo is not a campaign number are not joins, accept them as they are.
+          uint64_t memo_value;
+          if (!n1engine::parse_number(memo, memo_value)) {
+              return;
+          }
 
-          datacampaign_table datacampaign(get_self(), get_self().value);
-          auto existing_memo = datacampaign.get_index<"bymemo"_n>();
-          auto itr = existing_memo.find(memo_value);
+          campaignhot_table campaignhot(get_self(), get_self().value);
+          auto itr = campaignhot.find(n1engine::find_memo(get_self(), memo_value).value);
 
-          if (itr != existing_memo.end()) {
+          if (itr != campaignhot.end()) {
               time_point_sec current_time = current_time_point();
-              uint64_t current_time_sec = current_time.sec_since_epoch();
 
-              if (current_time_sec < itr->start) {
-                  eosio::check(false, "Campaign has not yet started");
-              }
-              
-              if (current_time_sec > itr->finish) {
-                  eosio::check(false, "This campaign has already ended");
-              }
+              n1engine::check_active(itr->start, itr->finish);
 
-              if (quantity != itr->entry) {
+              if (itr->weighted) {
+                  if (quantity.symbol != itr->entry.symbol || quantity < itr->entry) {
+                      eosio::check(false, "Number of tokens is lower than the minimum entry");
+                  }
+              } else if (quantity != itr->entry) {
                   eosio::check(false, "Number of tokens does not match specified entry");
               }
 
-              if (itr->printondemand == 0) {
-                stakers_table stakers_table(get_self(), get_self().value);
-                stakers_table.emplace(get_self(), [&](auto& row) {
+              n1engine::check_eligible(get_self(), itr->campaign, from);
+
+              // Weighted stakes take a reward of the highest stake level they reach, if any is left.
+              uint64_t level = itr->weighted && itr->printondemand == 0 ? reserve_level(itr->campaign, quantity) : 0;
+
+              if (itr->printondemand == 0 && itr->lazyassign) {
+                if (level == 0 && itr->available_rewards == 0) {
+                  eosio::check(false, "No reward was found available for this campaign.");
+                }
+
+                campaignhot.modify(itr, get_self(), [&](auto& row) {
+                  row.rev = n1engine::next_revision(get_self());
+                  if (level == 0) {
+                    row.available_rewards--;
+                  }
+                  if (row.weighted) {
+                    row.total_staked += quantity;
+                  }
+                });
+
+                store_staker(itr->campaign, itr->userram, from, [&](auto& row) {
+                  row.rev = n1engine::next_revision(get_self());
+                  row.participant = from;
+                  row.campaign = itr->campaign;
+                  row.join_time = current_time.sec_since_epoch();
+                  row.claimable_reward = current_time.sec_since_epoch() + itr->timetoreward;
+                  row.claimed = false;
+                  row.retired = false;
+                  row.id_asigned = 0;
+                  row.staked = quantity;
+                  row.level = level;
+                });
+
+                n1engine::send_receipt(get_self(), itr->campaign, from, quantity, 0, n1engine::receipt_status::joined);
+              }
+              else if (itr->printondemand == 0) {
+                if (itr->weighted) {
+                  campaignhot.modify(itr, get_self(), [&](auto& row) {
+                    row.rev = n1engine::next_revision(get_self());
+                    row.total_staked += quantity;
+                  });
+                }
+
+                store_staker(itr->campaign, itr->userram, from, [&](auto& row) {
+                  row.rev = n1engine::next_revision(get_self());
                   row.participant = from;
                   row.campaign = itr->campaign;
                   row.join_time = current_time.sec_since_epoch();
                   row.claimable_reward = current_time.sec_since_epoch() + itr->timetoreward;
                   row.claimed = false;
                   row.retired = false;
+                  row.staked = quantity;
+                  row.level = level;
 
                   rewards_table rewards(get_self(), get_self().value);
-                  auto rewards_itr = rewards.get_index<"bycampaign"_n>();
-                  auto rewards_entry = rewards_itr.find(itr->campaign.value);
-                  while (rewards_entry != rewards_itr.end() && rewards_entry->available == false) {
+                  auto rewards_itr = rewards.get_index<"bylevel"_n>();
+                  uint128_t level_key = rewards::level_key(itr->campaign, level);
+                  auto rewards_entry = rewards_itr.lower_bound(level_key);
+                  while (rewards_entry != rewards_itr.end() && rewards_entry->by_level() == level_key && rewards_entry->available == false) {
                       rewards_entry++;
                   }
-                  if (rewards_entry != rewards_itr.end()) {
+                  if (rewards_entry != rewards_itr.end() && rewards_entry->by_level() == level_key) {
                       row.id_asigned = rewards_entry->id;
                       rewards_itr.modify(rewards_entry, get_self(), [&](auto& r) {
+                          r.rev = n1engine::next_revision(get_self());
                           r.available = false;
                       });
                   } else {
@@ -306,6 +1024,7 @@ public:
                   }
                 });
 
+                n1engine::send_receipt(get_self(), itr->campaign, from, quantity, 0, n1engine::receipt_status::joined);
               }
               else if (itr->printondemand == 1) {
                 eosio::check(false, "Printondemand does not require filling");
@@ -328,82 +1047,73 @@ public:
       auto staker_entry = stakers.find(user.value);
 
       if (staker_entry != stakers.end()) {
-          if (staker_entry->claimed || staker_entry->retired) {
-          eosio::check(false, "Already claimed or withdrawn from this campaign");
+          if (staker_entry->join_time == 0) {
+          eosio::check(false, "Your position has no tokens staked");
           }
 
-          
-          time_point_sec current_time = current_time_point();
-          uint64_t current_time_sec = current_time.sec_since_epoch();
-          
-          uint64_t claimable_reward_time = staker_entry->claimable_reward;
-
-          if (current_time_sec < claimable_reward_time) {
-              eosio::check(false, "You have not completed stake time yet!");
-          }
+          n1engine::check_claimable(staker_entry->claimed, staker_entry->retired, staker_entry->claimable_reward);
 
           name campaign = staker_entry->campaign;
 
-          datacampaign_table datacampaign(get_self(), get_self().value);
-          auto datacampaign_entry = datacampaign.find(campaign.value);
+          campaignhot_table campaignhot(get_self(), get_self().value);
+          auto campaign_entry = campaignhot.find(campaign.value);
+
+          if (campaign_entry != campaignhot.end()) {
+              // Exactly one of 'islimited' and 'printondemand' is set, the hot row keeps the second.
+              bool islimited = !campaign_entry->printondemand;
+              bool printondemand = campaign_entry->printondemand;
+              bool return_entry = campaign_entry->return_entry;
 
-          if (datacampaign_entry != datacampaign.end()) {
-              bool islimited = datacampaign_entry->islimited;
-              bool printondemand = datacampaign_entry->printondemand;
-              bool return_entry = datacampaign_entry->return_entry;
+              asset entry_value = campaign_entry->weighted ? staker_entry->staked : campaign_entry->entry;
 
-              asset entry_value = datacampaign_entry->entry;
+              if (campaign_entry->weighted) {
+                  campaignhot.modify(campaign_entry, get_self(), [&](auto& row) {
+                      row.rev = n1engine::next_revision(get_self());
+                      row.total_staked -= entry_value;
+                  });
+              }
 
-              name token_account = datacampaign_entry->tokenaccount;
+              name token_account = campaign_entry->tokenaccount;
 
               if (islimited) {
-                  name external_contract = datacampaign_entry->nftaccount;
-                  uint64_t nftreward = staker_entry->id_asigned;
-
-                  std::vector<uint64_t> assetids_str;
-                  assetids_str.push_back(nftreward);
-
-                if (return_entry == 0) {
-                  action(
-                    permission_level{get_self(), "active"_n},
-                    external_contract, 
-                    "transfer"_n,     
-                    std::make_tuple(get_self(), user, assetids_str, std::string("NFT claimed"))
-                  ).send();
-
-
-                } else {
-                
-                   action(
-                    permission_level{get_self(), "active"_n},
-                    external_contract, 
-                    "transfer"_n,     
-                    std::make_tuple(get_self(), user, assetids_str, std::string("NFT claimed"))
-                  ).send();
-
-                  action(
-                    permission_level{get_self(), "active"_n},
-                    token_account, 
-                    "transfer"_n,
-                    std::make_tuple(get_self(), user, entry_value, std::string("Returned entry"))
-                   ).send();
-                  }
+                  name external_contract = campaign_entry->nftaccount;
+                  bool lazyassign = campaign_entry->lazyassign;
+                  uint64_t nftreward = lazyassign ? take_reward(campaign, staker_entry->level) : staker_entry->id_asigned;
 
-                  stakers.modify(staker_entry, get_self(), [&](auto& row) {
-                      row.claimed = true;
-                  });
+                  tokentonft_engine::payout(get_self(), external_contract, user, asset(), nftreward, "NFT claimed");
 
-                  rewards_table rewards(get_self(), get_self().value);
-                  auto rewards_entry = rewards.find(staker_entry->id_asigned);
+                  if (return_entry) {
+                    tokentonft_engine::refund(get_self(), token_account, user, entry_value, 0, "Returned entry");
+                  }
 
-                  if (rewards_entry != rewards.end()) {
-                      rewards.modify(rewards_entry, get_self(), [&](auto& row) {
-                          row.delivered = true;
-                      });
+                  // Rows paid by the user are deleted so the RAM goes back to them.
+                  if (campaign_entry->userram) {
+                      n1engine::mark_closed(get_self(), user, "accounts"_n, user.value);
+                      n1engine::record_erase(get_self(), "stakers"_n, user.value);
+                      stakers.erase(staker_entry);
                   } else {
-                      eosio::check(false, "No corresponding entry was found in rewards table.");
+                      stakers.modify(staker_entry, get_self(), [&](auto& row) {
+                          row.rev = n1engine::next_revision(get_self());
+                          row.claimed = true;
+                          row.id_asigned = nftreward;
+                      });
+                  }
+
+                  if (!lazyassign) {
+                      rewards_table rewards(get_self(), get_self().value);
+                      auto rewards_entry = rewards.find(nftreward);
+
+                      if (rewards_entry != rewards.end()) {
+                          rewards.modify(rewards_entry, get_self(), [&](auto& row) {
+                              row.rev = n1engine::next_revision(get_self());
+                              row.delivered = true;
+                          });
+                      } else {
+                          eosio::check(false, "No corresponding entry was found in rewards table.");
+                      }
                   }
 
+                  n1engine::send_receipt(get_self(), campaign, user, entry_value, nftreward, n1engine::receipt_status::claimed);
 
               } else if (printondemand) {
                   // TODO 
@@ -431,48 +1141,81 @@ public:
       auto staker_entry = stakers.find(user.value);
 
       if (staker_entry != stakers.end()) {
-          if (staker_entry->claimed || staker_entry->retired) {
-              eosio::check(false, "Already claimed or withdrawn from this campaign");
+          if (staker_entry->join_time == 0) {
+              eosio::check(false, "Your position has no tokens staked");
           }
 
+          n1engine::check_retirable(staker_entry->claimed, staker_entry->retired, staker_entry->claimable_reward);
+
           time_point_sec current_time = current_time_point();
           uint64_t current_time_sec = current_time.sec_since_epoch();
 
-          if (current_time_sec < staker_entry->claimable_reward) {
-              name campaign = staker_entry->campaign;
+          name campaign = staker_entry->campaign;
 
-              datacampaign_table datacampaign(get_self(), get_self().value);
-              auto datacampaign_entry = datacampaign.find(campaign.value);
+          campaignhot_table campaignhot(get_self(), get_self().value);
+          auto campaign_entry = campaignhot.find(campaign.value);
 
-              if (datacampaign_entry != datacampaign.end()) {
-                  asset entry_value = datacampaign_entry->entry;
-                  name token_account = datacampaign_entry->tokenaccount;
+          if (campaign_entry != campaignhot.end()) {
+              asset entry_value = campaign_entry->weighted ? staker_entry->staked : campaign_entry->entry;
+              name token_account = campaign_entry->tokenaccount;
+              uint64_t id_asigned = staker_entry->id_asigned;
+              uint64_t level = staker_entry->level;
 
-                  action(
-                    permission_level{get_self(), "active"_n},
-                    token_account, 
-                    "transfer"_n,  
-                    std::make_tuple(get_self(), user, entry_value, std::string("Returned entry"))
-                  ).send();
+              if (campaign_entry->cooldown == 0) {
+              tokentonft_engine::refund(get_self(), token_account, user, entry_value, 0, "Returned entry");
+              } else {
+              releases_table releases(get_self(), get_self().value);
+              releases.emplace(user, [&](auto &row) {
+              row.id = releases.available_primary_key();
+              row.account = user;
+              row.tokenaccount = token_account;
+              row.quantity = entry_value;
+              row.due = current_time_sec + campaign_entry->cooldown;
+              });
+              }
 
-                  stakers.modify(staker_entry, user, [&](auto &staker) {
-                  staker.retired = true;
-                  });
+              if (campaign_entry->userram) {
+              n1engine::mark_closed(get_self(), user, "accounts"_n, user.value);
+              n1engine::record_erase(get_self(), "stakers"_n, user.value);
+              stakers.erase(staker_entry);
+              } else {
+              stakers.modify(staker_entry, user, [&](auto &staker) {
+              staker.rev = n1engine::next_revision(get_self());
+              staker.retired = true;
+              });
+              }
 
-                  rewards_table rewards(get_self(), get_self().value);
-                  auto reward_entry = rewards.find(staker_entry->id_asigned);
-                  if (reward_entry != rewards.end()) {
-                  rewards.modify(reward_entry, user, [&](auto &reward) {
-                  reward.available = true;
+              if (campaign_entry->lazyassign || campaign_entry->weighted) {
+              campaignhot.modify(campaign_entry, get_self(), [&](auto &row) {
+              row.rev = n1engine::next_revision(get_self());
+              if (row.lazyassign && level == 0) {
+              row.available_rewards++;
+              }
+              if (row.weighted) {
+              row.total_staked -= entry_value;
+              }
               });
-                  }
+              }
 
-              } else {
-                  eosio::check(false, "No matching entry found in datacampaign table");
+              if (level != 0) {
+              release_level(campaign, level);
               }
 
+              if (!campaign_entry->lazyassign) {
+              rewards_table rewards(get_self(), get_self().value);
+              auto reward_entry = rewards.find(id_asigned);
+              if (reward_entry != rewards.end()) {
+              rewards.modify(reward_entry, user, [&](auto &reward) {
+              reward.rev = n1engine::next_revision(get_self());
+              reward.available = true;
+          });
+              }
+              }
+
+              n1engine::send_receipt(get_self(), campaign, user, entry_value, id_asigned, n1engine::receipt_status::retired);
+
           } else {
-              eosio::check(false, "Stake completed, you must claim your reward");
+              eosio::check(false, "No matching entry found in datacampaign table");
           }
       } else {
           eosio::check(false, "No matching entry was found in stakers table.");
@@ -499,6 +1242,7 @@ public:
 
       while (staker_entry != staker_end) {
           if (staker_entry->campaign == camptoclear) {
+              n1engine::record_erase(get_self(), "stakers"_n, staker_entry->participant.value);
               staker_entry = stakers.erase(staker_entry);
               foundEntries = true; 
           } else {
@@ -513,6 +1257,150 @@ public:
 
 
 private:
+  // Validates and stores a new campaign, shared by newcampign and setcampaigns.
+  void create_campaign(name campaign, name filler, uint64_t start, uint64_t finish,
+                       uint64_t timetoreward, name nftaccount, name tokenaccount,
+                       asset entry, bool return_entry, uint64_t places, bool islimited,
+                       bool printondemand, uint64_t memo_expected) {
+    datacampaign_table datacampaign(get_self(), get_self().value);
+    auto existing = datacampaign.find(campaign.value);
+    check(existing == datacampaign.end(), "Campaign already exists");
+
+    check(memo_expected > 0, "memo_expected must be a valid number");
+
+    n1engine::add_memo(get_self(), memo_expected, campaign);
+
+    n1engine::check_schedule(start, finish, timetoreward);
+
+    if (!((islimited && !printondemand) || (!islimited && printondemand))) {
+      check(false, "Select exactly one, 'islimited' or 'printondemand'.");
+    }
+
+    
+    if (printondemand && places != 0) {
+      eosio::check(false, "Places must be 0 (unlimited) when 'printondemand' is active");
+    }
+
+    
+    datacampaign.emplace(get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.campaign = campaign;
+      row.filler = filler;
+      row.start = start;
+      row.finish = finish;
+      row.timetoreward = timetoreward;
+      row.nftaccount = nftaccount;
+      row.tokenaccount = tokenaccount;
+      row.entry = entry;
+      row.return_entry = return_entry;
+      row.places = places;
+      row.islimited = islimited;
+      row.printondemand = printondemand;
+      row.memo_expected = memo_expected;
+    });
+
+    campaignhot_table campaignhot(get_self(), get_self().value);
+    campaignhot.emplace(get_self(), [&](auto& row) {
+      row.rev = n1engine::next_revision(get_self());
+      row.campaign = campaign;
+      row.start = start;
+      row.finish = finish;
+      row.timetoreward = timetoreward;
+      row.nftaccount = nftaccount;
+      row.tokenaccount = tokenaccount;
+      row.entry = entry;
+      row.return_entry = return_entry;
+      row.printondemand = printondemand;
+      row.lazyassign = false;
+      row.available_rewards = 0;
+      row.weighted = false;
+      row.total_staked = asset(0, entry.symbol);
+      row.cooldown = 0;
+      row.userram = false;
+    });
+
+    n1engine::send_receipt(get_self(), campaign, get_self(), entry, 0, n1engine::receipt_status::created);
+  }
+
+
+  // Stores a new position in the row the user opened for a 'userram' campaign,
+  // otherwise in a new row paid by the contract.
+  template <typename Fn>
+  void store_staker(name campaign, bool userram, name user, Fn&& fill) {
+    n1engine::check_not_closed(get_self(), "accounts"_n, user.value, "You are already participating or have participated.");
+
+    stakers_table stakers(get_self(), get_self().value);
+    auto staker_entry = stakers.find(user.value);
+
+    if (staker_entry != stakers.end() && staker_entry->join_time == 0 && staker_entry->campaign == campaign) {
+      stakers.modify(staker_entry, user, fill);
+      return;
+    }
+
+    if (userram) {
+      check(false, "Call 'open' before the transfer to pay for your position");
+    }
+
+    stakers.emplace(get_self(), fill);
+  }
+
+
+  // Takes the first reward of a campaign and stake level out of the rewards table.
+  // Used by 'lazyassign' campaigns, where join only reserves a place in 'available_rewards'
+  // or in the stake level. Delivered rewards are erased, so the first row is always available.
+  uint64_t take_reward(name campaign, uint64_t level) {
+      rewards_table rewards(get_self(), get_self().value);
+      auto by_level = rewards.get_index<"bylevel"_n>();
+      auto reward_entry = by_level.lower_bound(rewards::level_key(campaign, level));
+
+      if (reward_entry == by_level.end() || reward_entry->by_level() != rewards::level_key(campaign, level)) {
+          eosio::check(false, "No reward was found available for this campaign.");
+      }
+
+      uint64_t id = reward_entry->id;
+      n1engine::record_erase(get_self(), "rewards"_n, id);
+      by_level.erase(reward_entry);
+      return id;
+  }
+
+
+  // Reserves a reward for a weighted stake: one of the stake level with the highest
+  // 'min_stake' not above 'quantity' that has rewards left. Returns 0, the campaign's
+  // own rewards, when the stake reaches no such level.
+  uint64_t reserve_level(name campaign, const asset& quantity) {
+      stakelevels_table stakelevels(get_self(), campaign.value);
+      auto level_entry = stakelevels.end();
+
+      for (auto itr = stakelevels.begin(); itr != stakelevels.end(); ++itr) {
+          if (itr->available > 0 && itr->min_stake <= quantity &&
+              (level_entry == stakelevels.end() || itr->min_stake > level_entry->min_stake)) {
+              level_entry = itr;
+          }
+      }
+
+      if (level_entry == stakelevels.end()) {
+          return 0;
+      }
+
+      stakelevels.modify(level_entry, get_self(), [&](auto& row) {
+          row.available--;
+      });
+      return level_entry->level;
+  }
+
+
+  // Gives back the reward reserved by 'reserve_level' when the position is withdrawn.
+  void release_level(name campaign, uint64_t level) {
+      stakelevels_table stakelevels(get_self(), campaign.value);
+      auto level_entry = stakelevels.find(level);
+      if (level_entry != stakelevels.end()) {
+          stakelevels.modify(level_entry, get_self(), [&](auto& row) {
+              row.available++;
+          });
+      }
+  }
+
+
   struct [[eosio::table]] datacampaign {
     name campaign;
     name filler;
@@ -527,9 +1415,35 @@ private:
     bool islimited;
     bool printondemand;
     uint64_t memo_expected;
+    uint64_t rev;
 
     uint64_t primary_key() const { return campaign.value; }
-    uint64_t by_memo_expected() const { return memo_expected; }
+    uint64_t by_rev() const { return rev; }
+  };
+
+
+  // Subset of datacampaign read on every join, claim and retire, plus the settings and
+  // counters changed after creation. Kept in sync by updcampaign and delcampaign.
+  struct [[eosio::table]] campaignhot {
+    name campaign;
+    uint64_t start;
+    uint64_t finish;
+    uint64_t timetoreward;
+    name nftaccount;
+    name tokenaccount;
+    asset entry;
+    bool return_entry;
+    bool printondemand;
+    bool lazyassign;
+    uint64_t available_rewards;
+    bool weighted;
+    asset total_staked;
+    uint64_t cooldown;
+    bool userram;
+    uint64_t rev;
+
+    uint64_t primary_key() const { return campaign.value; }
+    uint64_t by_rev() const { return rev; }
   };
 
 
@@ -538,9 +1452,29 @@ private:
     name campaign;        
     bool available;       
     bool delivered;       
+    uint64_t rev;
+    uint64_t level;
 
     uint64_t primary_key() const { return id; }
     uint64_t by_campaign() const { return campaign.value; }
+    uint64_t by_rev() const { return rev; }
+    uint128_t by_level() const { return level_key(campaign, level); }
+
+    // Orders rewards by campaign, then by stake level.
+    static uint128_t level_key(name campaign, uint64_t level) {
+      return (uint128_t(campaign.value) << 64) | level;
+    }
+  };
+
+
+  // Stake levels of a weighted campaign, scoped by campaign. A stake of at least 'min_stake'
+  // receives a reward deposited for the level, level 0 being the campaign's own 'entry'.
+  struct [[eosio::table]] stakelevels {
+    uint64_t level;
+    asset min_stake;
+    uint64_t available;
+
+    uint64_t primary_key() const { return level; }
   };
 
 
@@ -552,26 +1486,132 @@ private:
     bool claimed;
     bool retired; 
     uint64_t id_asigned;
+    asset staked;
+    uint64_t rev;
+    uint64_t level;
 
     uint64_t primary_key() const { return participant.value; }
     uint64_t by_campaign() const { return campaign.value; }
+    uint64_t by_rev() const { return rev; }
+    uint128_t by_stake() const { return stake_key(campaign, claimed || retired ? 0 : staked.amount); }
+
+    // Orders stakers by campaign, then by staked amount. Claimed and retired positions count as 0.
+    static uint128_t stake_key(name campaign, uint64_t amount) {
+      return (uint128_t(campaign.value) << 64) | amount;
+    }
+  };
+
+
+  // Retired entries waiting for their cooldown, released by the 'release' action.
+  struct [[eosio::table]] releases {
+    uint64_t id;
+    name account;
+    name tokenaccount;
+    asset quantity;
+    uint64_t due;
+
+    uint64_t primary_key() const { return id; }
+    uint64_t by_due() const { return due; }
   };
 
 
   typedef eosio::multi_index<"datacampaign"_n, datacampaign, 
-    indexed_by<"bymemo"_n, const_mem_fun<datacampaign, uint64_t, &datacampaign::by_memo_expected>>
+    indexed_by<"byrev"_n, const_mem_fun<datacampaign, uint64_t, &datacampaign::by_rev>>
   > datacampaign_table;
 
 
+  typedef eosio::multi_index<"campaignhot"_n, campaignhot,
+    indexed_by<"byrev"_n, const_mem_fun<campaignhot, uint64_t, &campaignhot::by_rev>>
+  > campaignhot_table;
+
+
+  typedef eosio::multi_index<"releases"_n, releases,
+    indexed_by<"bydue"_n, const_mem_fun<releases, uint64_t, &releases::by_due>>
+  > releases_table;
+
+
   typedef eosio::multi_index<"rewards"_n, rewards,
-    indexed_by<"bycampaign"_n, const_mem_fun<rewards, uint64_t, &rewards::by_campaign>>
+    indexed_by<"bycampaign"_n, const_mem_fun<rewards, uint64_t, &rewards::by_campaign>>,
+    indexed_by<"byrev"_n, const_mem_fun<rewards, uint64_t, &rewards::by_rev>>,
+    indexed_by<"bylevel"_n, const_mem_fun<rewards, uint128_t, &rewards::by_level>>
   > rewards_table;
 
 
+  typedef eosio::multi_index<"stakelevels"_n, stakelevels> stakelevels_table;
+
+
   typedef eosio::multi_index<"stakers"_n, stakers,
-    indexed_by<"bycampaign"_n, const_mem_fun<stakers, uint64_t, &stakers::by_campaign>>
+    indexed_by<"bycampaign"_n, const_mem_fun<stakers, uint64_t, &stakers::by_campaign>>,
+    indexed_by<"bystake"_n, const_mem_fun<stakers, uint128_t, &stakers::by_stake>>,
+    indexed_by<"byrev"_n, const_mem_fun<stakers, uint64_t, &stakers::by_rev>>
   > stakers_table;
 
+
+  // Layouts and indexes deployed before this version, only read by 'migrate'. The first field
+  // added since then is an extension, present only in rows already in the current layout.
+  struct legacy_datacampaign {
+    name campaign;
+    name filler;
+    uint64_t start;
+    uint64_t finish;
+    uint64_t timetoreward;
+    name nftaccount;
+    name tokenaccount;
+    asset entry;
+    bool return_entry;
+    uint64_t places;
+    bool islimited;
+    bool printondemand;
+    uint64_t memo_expected;
+    binary_extension<uint64_t> rev;
+
+    uint64_t primary_key() const { return campaign.value; }
+    uint64_t by_memo_expected() const { return memo_expected; }
+    bool upgraded() const { return rev.has_value(); }
+  };
+
+
+  struct legacy_rewards {
+    uint64_t id;
+    name campaign;
+    bool available;
+    bool delivered;
+    binary_extension<uint64_t> rev;
+
+    uint64_t primary_key() const { return id; }
+    uint64_t by_campaign() const { return campaign.value; }
+    bool upgraded() const { return rev.has_value(); }
+  };
+
+
+  struct legacy_stakers {
+    name participant;
+    name campaign;
+    uint64_t join_time;
+    uint64_t claimable_reward;
+    bool claimed;
+    bool retired;
+    uint64_t id_asigned;
+    binary_extension<asset> staked;
+
+    uint64_t primary_key() const { return participant.value; }
+    uint64_t by_campaign() const { return campaign.value; }
+    bool upgraded() const { return staked.has_value(); }
+  };
+
+
+  typedef eosio::multi_index<"datacampaign"_n, legacy_datacampaign,
+    indexed_by<"bymemo"_n, const_mem_fun<legacy_datacampaign, uint64_t, &legacy_datacampaign::by_memo_expected>>
+  > legacy_datacampaign_table;
+
+  typedef eosio::multi_index<"rewards"_n, legacy_rewards,
+    indexed_by<"bycampaign"_n, const_mem_fun<legacy_rewards, uint64_t, &legacy_rewards::by_campaign>>
+  > legacy_rewards_table;
+
+  typedef eosio::multi_index<"stakers"_n, legacy_stakers,
+    indexed_by<"bycampaign"_n, const_mem_fun<legacy_stakers, uint64_t, &legacy_stakers::by_campaign>>
+  > legacy_stakers_table;
+
 };
 
 